@@ -4,17 +4,32 @@
 #include <sstream>
 
 namespace miniplc0 {
-    std::vector<miniplc0::Instruction> _instructions;
-    std::pair<Program, std::optional<CompilationError>> Analyser::Analyse() {
+    std::optional<CompilationError> Analyser::analyse() {
         _funcRetType=NULL_TOKEN;
         auto err = analyseProgram();
+        // 表达式结点在生成指令后就不再使用了
+        _arena.Release();
+        // 流式分析时读完剩下的 token，保证和先做完词法分析一样，词法错误优先于语法错误
+        if (_tokenizer != nullptr)
+            while (pullToken().has_value())
+                ;
+        if (_token_error.has_value())
+            return _token_error;
+        return err;
+    }
+
+    Analyser::Result Analyser::Analyse() & {
+        auto err = analyse();
         if (err.has_value())
-            return std::make_pair(Program(), err);
-        else {
-            auto Pro = Program(_CONSTS, _funcs, _program);
-            return std::make_pair(Pro, std::optional<CompilationError>());
-            printf("hello");
-        }
+            return Result{ Program(), err, _token_error.has_value() };
+        return Result{ Program(_consts.Items(), _funcs, _program), std::optional<CompilationError>(), false };
+    }
+
+    Analyser::Result Analyser::Analyse() && {
+        auto err = analyse();
+        if (err.has_value())
+            return Result{ Program(), err, _token_error.has_value() };
+        return Result{ Program(std::move(_consts).Items(), std::move(_funcs), std::move(_program)), std::optional<CompilationError>(), false };
     }
 //	std::pair<std::vector<Instruction>, std::optional<CompilationError>> Analyser::Analyse() {
 //		auto err = analyseProgram();
@@ -61,7 +76,6 @@ namespace miniplc0 {
         if(variableDeclarationError.has_value())
             return variableDeclarationError;
 
-        createStack();
 		// <语句序列>
         auto functionDefinitionError = analyseFunctionDefinition();
         if(functionDefinitionError.has_value())
@@ -84,8 +98,7 @@ namespace miniplc0 {
     // <variable-declaration> ::= {<variable-declaration-statement>}
     // <variable-declaration-statement> ::= ['const']'int'<init-declarator-list>';'
 
-    // 定义一个全局变量 hasConst方便init-declarator-list里面进行直接引用
-    int hasConst = 0;
+    // _hasConst 记录当前声明语句是否有 const，方便 init-declarator-list 里面直接引用
     std::optional<CompilationError> Analyser::analyseVariableDeclaration() {
 		// 变量声明语句可能有一个或者多个
         while(true){
@@ -103,9 +116,9 @@ namespace miniplc0 {
             // 情况二：token是const
             // 如果是 const 那么说明是常量
             // 由于const 可有可无 使用 == 判断 在if内部读取nextToken
-            hasConst = 0;
+            _hasConst = 0;
             if (next.value().GetType() == TokenType::CONST) {
-                hasConst = 1;
+                _hasConst = 1;
                 next = nextToken();
             }
 
@@ -124,23 +137,27 @@ namespace miniplc0 {
             //      1、如果前面有const，那么肯定语法错误，直接报错
             //      2、如果前面没有const，那么在一开始的value检查的时候就会返回，不会运行到这里
             // 如果有value，继续||后面的分析
-            if (!next.has_value() || (next.value().GetType() != TokenType::INT && hasConst == 1)) {
+            if (!next.has_value() || (next.value().GetType() != TokenType::INT && _hasConst == 1)) {
                 return std::make_optional<CompilationError>(_current_pos, ErrorCode::ErrInvalidVariableDeclaration);
-            }else if (next.value().GetType() != TokenType::INT && hasConst == 0){
+            }else if (next.value().GetType() != TokenType::INT && _hasConst == 0){
                 unreadToken();
                 return {};
             }
 
-            nextToken();
+            // 再看两个 token，int <identifier> '(' 是函数定义
+            // 读到结尾时 nextToken 不前进，回退的次数要和真正读到的 token 数一致
+            auto name = nextToken();
             next = nextToken();
-            if(next.value().GetType() == TokenType::LEFT_BRACKET){
+            if(next.has_value() && next.value().GetType() == TokenType::LEFT_BRACKET){
                 unreadToken();
                 unreadToken();
                 unreadToken();
                 return {};
             }else{
-                unreadToken();
-                unreadToken();
+                if (next.has_value())
+                    unreadToken();
+                if (name.has_value())
+                    unreadToken();
             }
 
             // int 被匹配了 每个函数都以nextToken()开头，这里不要用nextToken
@@ -151,7 +168,6 @@ namespace miniplc0 {
 
             // ';'
             next = nextToken();
-            auto a = next.value().GetType();
             if (!next.has_value() || next.value().GetType() != TokenType::SEMICOLON){
                 return std::make_optional<CompilationError>(_current_pos, ErrorCode::ErrNoSemicolon);
             }
@@ -225,8 +241,9 @@ namespace miniplc0 {
         // 1、后面没有东西了
         // 2、后面的东西不是'='
         if (!next.has_value() || next.value().GetType() != TokenType::EQUAL_SIGN){
-            unreadToken();
-            if (hasConst)
+            if (next.has_value())
+                unreadToken();
+            if (_hasConst)
                 return std::make_optional<CompilationError>(_current_pos, ErrorCode::ErrConstantNeedValue);
             addUninitializedVariable(tmp.value(), TokenType::UNSIGNED_INTEGER);
             _instructions.emplace_back(Operation::IPUSH, 0);
@@ -240,12 +257,18 @@ namespace miniplc0 {
         auto err = analyseExpression();
         if (err.second.has_value())
             return err.second;
-        auto ty=err.first.value()->gen();
+        // 初值在编译期就能算出来的常量不占栈上的位置，使用的地方直接 ipush
+        auto value = err.first.value()->signedConstant();
+        if (_hasConst == 1 && value.has_value()) {
+            addConstant(tmp.value(), TokenType::UNSIGNED_INTEGER, value.value());
+            return {};
+        }
+        auto ty=err.first.value()->gen(_instructions);
         if(ty==VOID)
             return std::make_optional<CompilationError>(_current_pos,
                                                         ErrorCode::ErrAssignmentExpression);
         // 加入常量变量表
-        if (hasConst == 1)
+        if (_hasConst == 1)
             addConstant(tmp.value(), TokenType::UNSIGNED_INTEGER);
         else
             addVariable(tmp.value(), TokenType::UNSIGNED_INTEGER);
@@ -270,7 +293,7 @@ namespace miniplc0 {
 		auto err = analyseMultiplicativeExpression();
         if (err.second.has_value())
             return std::make_pair(std::optional<Expression*>(), err.second);
-        items.emplace_back(err.first.value());
+        items.emplace_back(std::move(err.first.value()));
 
 
 		// {<additive-operator><multiplicative-expression>}
@@ -279,21 +302,21 @@ namespace miniplc0 {
 			// 预读 判断是否正常结束匹配
 			auto next = nextToken();
 			if (!next.has_value())
-                return std::make_pair(new Expression(TokenType::NULL_TOKEN, ops, items), std::optional<CompilationError>());
+                return std::make_pair(_arena.Make<Expression>(TokenType::NULL_TOKEN, std::move(ops), std::move(items)), std::optional<CompilationError>());
 
 			// 正式进入匹配
 			// 匹配 <additive-operator>
 			auto type = next.value().GetType();
 			if (type != TokenType::PLUS_SIGN && type != TokenType::MINUS_SIGN) {
 				unreadToken();
-                return std::make_pair(new Expression(TokenType::NULL_TOKEN, ops, items), std::optional<CompilationError>());
+                return std::make_pair(_arena.Make<Expression>(TokenType::NULL_TOKEN, std::move(ops), std::move(items)), std::optional<CompilationError>());
 			}
 
 			// <multiplicative-expression>
 			err = analyseMultiplicativeExpression();
             if (err.second.has_value())
                 return std::make_pair(std::optional<Expression*>(), err.second);
-            items.emplace_back(err.first.value());
+            items.emplace_back(std::move(err.first.value()));
             ops.emplace_back(type);
 
 			// 根据结果生成指令
@@ -330,13 +353,13 @@ namespace miniplc0 {
             // 预读
             auto next = nextToken();
             if (!next.has_value())
-                return std::make_pair(Item(facs,ops),std::optional<CompilationError>());
+                return std::make_pair(Item(std::move(facs), std::move(ops), _fold),std::optional<CompilationError>());
 
             // 匹配 <multiplicative-operator>
             auto type = next.value().GetType();
             if (type != TokenType::MULTIPLICATION_SIGN && type != TokenType::DIVISION_SIGN) {
                 unreadToken();
-                return std::make_pair(Item(facs,ops),std::optional<CompilationError>());
+                return std::make_pair(Item(std::move(facs), std::move(ops), _fold),std::optional<CompilationError>());
             }
 
             // <unary-expression>
@@ -390,8 +413,9 @@ namespace miniplc0 {
                 if(!next.has_value() || next.value().GetType() != TokenType::LEFT_BRACKET){
                     if (isDeclared(str)) {
                         Var var = getVar(str);
-                        unreadToken();
-                        return std::make_pair(new Variable(sign, var), std::optional<CompilationError>());
+                        if (next.has_value())
+                            unreadToken();
+                        return std::make_pair(_arena.Make<Variable>(sign, var), std::optional<CompilationError>());
                         //利用标识符找到常量、变量在栈中的索引，利用load指令载入identifi的值
                     }else{
                         return std::make_pair(std::optional<MulItem*>(),
@@ -405,6 +429,7 @@ namespace miniplc0 {
                         auto err = analyseFunctionCall();
                         if (err.second.has_value())
                             return std::make_pair(std::optional<Analyser::MulItem *>(), err.second);
+                        err.first.value()->sign = sign;
                         return std::make_pair(err.first, std::optional<CompilationError>());
                     } else {
                         return std::make_pair(std::optional<MulItem *>(),
@@ -415,13 +440,9 @@ namespace miniplc0 {
             }
             case TokenType::UNSIGNED_INTEGER:
             case TokenType::UNSIGNED_HEX_INTEGER:
-                uint32_t k;
-                if (!checkState(next.value())) {
-                    addCONST(next.value());
-                    k = _CONSTS.size() - 1;
-                } else
-                    k = getConstIndex(next.value());
-                return std::make_pair(new Integer(sign, k), std::optional<CompilationError>());
+                return std::make_pair(_arena.Make<Integer>(sign, _consts.Int(next.value().GetIntValue()),
+                                                           next.value().GetIntValue()),
+                                      std::optional<CompilationError>());
             case TokenType::LEFT_BRACKET:{
                 auto err = analyseExpression();
                 if (err.second.has_value())
@@ -458,8 +479,9 @@ namespace miniplc0 {
     std::optional<CompilationError> Analyser::analyseFunctionDefinition(){
 	    while(true){
 	        // 进入新的函数作用域 保存当前指令
+            // 复制出一份大小正好的代码，_instructions 的缓冲区留给下一个函数复用
             _program.emplace_back(_instructions);
-            _instructions.erase(_instructions.begin(), _instructions.end());
+            _instructions.clear();
 
             auto next = nextToken();
             if(!next.has_value()){
@@ -485,9 +507,8 @@ namespace miniplc0 {
             std::string str = next.value().GetValueString();
             if (isFunctionDeclared(str))
                 return std::make_optional<CompilationError>(_current_pos, ErrorCode::ErrDuplicateDeclaration);
-            Token fun = next.value();
-            //函数名加入常量表，记录常量表中的index
-            addCONST(fun);
+            //函数名先加入常量表，占住它在参数分析之前的位置，addFunction 时再取下标
+            _consts.String(str);
             // 进入新的函数 设置为非全局变量
             // 保存当前区域变量表进入变量表的表
             isGlabol = false;
@@ -503,6 +524,10 @@ namespace miniplc0 {
             if (err.has_value())
                 return err;
             _instructions.emplace_back(RET,0);
+            _labels.Resolve(_instructions);
+            _labels.Clear();
+            // 这个函数的表达式树都已经生成了指令，峰值内存只和最大的函数有关
+            _arena.Release();
         }
         return {};
     }
@@ -682,7 +707,7 @@ namespace miniplc0 {
                         auto err = analyseFunctionCall();
                         if (err.second.has_value())
                             return err.second;
-                        err.first.value()->gen();
+                        err.first.value()->gen(_instructions);
                     }else{
                         return std::make_optional<CompilationError>(_current_pos, ErrorCode::ErrStatement);
                     }
@@ -732,7 +757,7 @@ namespace miniplc0 {
             auto err = analyseExpression();
             if (err.second.has_value())
                 return err.second;
-            err.first.value()->gen();
+            err.first.value()->gen(_instructions);
             hasExp = 1;
             next = nextToken();
         }
@@ -772,10 +797,10 @@ namespace miniplc0 {
             return std::make_optional<CompilationError>(_current_pos, ErrorCode::ErrConditionStatement);
         }
 
-        auto err = analyseCondition();
-        if (err.second.has_value())
-            return err.second;
-        int jp=err.first.value();
+        auto elseLabel = _labels.New();
+        auto err = analyseCondition(elseLabel);
+        if (err.has_value())
+            return err;
 
         next = nextToken();
         if(!next.has_value() || next.value().GetType() != TokenType::RIGHT_BRACKET){
@@ -787,23 +812,24 @@ namespace miniplc0 {
             return err2;
 
         // If成立需要跳过else，如果没有else也要跳到后面
-        _instructions.emplace_back(JMP,0);
+        auto endLabel = _labels.New();
+        _instructions.emplace_back(JMP, endLabel);
 
-        int jp2=_instructions.size()-1;
         //if不成立跳到这里
-        _instructions[jp].SetX(_instructions.size());
+        _labels.Place(elseLabel, _instructions.size());
 
         next = nextToken();
         if(!next.has_value() || next.value().GetType() != TokenType::ELSE){
-            _instructions[jp2].SetX(_instructions.size());
-            unreadToken();
+            _labels.Place(endLabel, _instructions.size());
+            if (next.has_value())
+                unreadToken();
             return {};
         }
 
         err2 = analyseStatement();
         if (err2.has_value())
             return err2;
-        _instructions[jp2].SetX(_instructions.size());
+        _labels.Place(endLabel, _instructions.size());
         return {};
 
     }
@@ -811,11 +837,11 @@ namespace miniplc0 {
     // Done
     // Done
     // <condition> ::= <expression>[<relational-operator><expression>]
-    std::pair<std::optional<int32_t >,std::optional<CompilationError>> Analyser::analyseCondition(){
+    std::optional<CompilationError> Analyser::analyseCondition(int32_t label){
         auto err = analyseExpression();
         if (err.second.has_value())
-            return std::make_pair(std::optional<int32_t>(),err.second);
-        err.first.value()->gen();
+            return err.second;
+        err.first.value()->gen(_instructions);
 
         auto next = nextToken();
 
@@ -826,43 +852,44 @@ namespace miniplc0 {
                         next.value().GetType() != TokenType::BIG_EQUAL &&
                         next.value().GetType() != TokenType::NOT_EQUAL &&
                         next.value().GetType() != TokenType::EQUAL)){
-            unreadToken();
-            _instructions.emplace_back(Operation::JE, 0);
-            return std::make_pair(_instructions.size()-1,std::optional<CompilationError>());
+            if (next.has_value())
+                unreadToken();
+            _instructions.emplace_back(Operation::JE, label);
+            return {};
         }
 
         err = analyseExpression();
-        if (err.second.has_value()) return std::make_pair(std::make_optional(int32_t()),err.second);
-        err.first.value()->gen();
+        if (err.second.has_value()) return err.second;
+        err.first.value()->gen(_instructions);
         _instructions.emplace_back(Operation::ISUB, 0);
         switch (next.value().GetType()) {
             case TokenType::BIG:{
-                _instructions.emplace_back(Operation::JLE, 0);
+                _instructions.emplace_back(Operation::JLE, label);
                 break;
             }
             case TokenType::SMALL:{
-                _instructions.emplace_back(Operation::JGE, 0);
+                _instructions.emplace_back(Operation::JGE, label);
                 break;
             }
             case TokenType::BIG_EQUAL:{
-                _instructions.emplace_back(Operation::JL, 0);
+                _instructions.emplace_back(Operation::JL, label);
                 break;
             }
             case TokenType::SMALL_EQUAL:{
-                _instructions.emplace_back(Operation::JG, 0);
+                _instructions.emplace_back(Operation::JG, label);
                 break;
             }
             case TokenType::NOT_EQUAL:{
-                _instructions.emplace_back(Operation::JE, 0);
+                _instructions.emplace_back(Operation::JE, label);
                 break;
             }
             case TokenType::EQUAL:{
-                _instructions.emplace_back(Operation::JNE, 0);
+                _instructions.emplace_back(Operation::JNE, label);
                 break;
             }
             default: break;
         }
-        return std::make_pair(_instructions.size()-1,std::optional<CompilationError>());
+        return {};
     }
 
 
@@ -882,11 +909,11 @@ namespace miniplc0 {
         }
 
 
-        int s0=_instructions.size();
-        auto err = analyseCondition();
-        if (err.second.has_value())
-            return err.second;
-        int jcond=err.first.value();
+        auto condLabel = _labels.New(_instructions.size());
+        auto exitLabel = _labels.New();
+        auto err = analyseCondition(exitLabel);
+        if (err.has_value())
+            return err;
 
         next = nextToken();
         if(!next.has_value() || next.value().GetType() != TokenType::RIGHT_BRACKET){
@@ -896,8 +923,8 @@ namespace miniplc0 {
         auto Serr = analyseStatement();
         if (Serr.has_value())
             return Serr;
-        _instructions.emplace_back(JMP,s0);
-        _instructions[jcond].SetX(_instructions.size());
+        _instructions.emplace_back(JMP, condLabel);
+        _labels.Place(exitLabel, _instructions.size());
         return {};
     }
 
@@ -923,6 +950,8 @@ namespace miniplc0 {
         std::string str = next.value().GetValueString();
         if (!isDeclared(str))
             return std::make_optional<CompilationError>(_current_pos, ErrorCode::ErrNotDeclared);
+        if (isConstant(str))
+            return std::make_optional<CompilationError>(_current_pos, ErrorCode::ErrAssignToConstant);
 
         int index, level;
         Var var=getVar(str);
@@ -995,7 +1024,8 @@ namespace miniplc0 {
         while(true){
             auto next = nextToken();
             if(!next.has_value() || next.value().GetType() != TokenType::COMMA){
-                unreadToken();
+                if (next.has_value())
+                    unreadToken();
                 return {};
             }
             _instructions.emplace_back(IPUSH,' ');
@@ -1015,7 +1045,7 @@ namespace miniplc0 {
         auto err = analyseExpression();
         if (err.second.has_value())
             return err.second;
-        err.first.value()->gen();
+        err.first.value()->gen(_instructions);
         _instructions.emplace_back(IPRINT, 0);
         return {};
     }
@@ -1049,7 +1079,7 @@ namespace miniplc0 {
 
         auto err = analyseExpression();
         if (err.second.has_value()) return err.second;
-        auto rettype=err.first.value()->gen();
+        auto rettype=err.first.value()->gen(_instructions);
         if(rettype==TokenType::VOID)
             return std::make_optional<CompilationError>(_current_pos, ErrorCode::ErrAssignmentExpression);
         _instructions.emplace_back(Operation::ISTORE, 0);
@@ -1131,6 +1161,8 @@ namespace miniplc0 {
     // <parameter-declaration> ::= [<const-qualifier>]<type-specifier><identifier>
     std::optional<CompilationError> Analyser::analyseParameterDeclaration(){
 	    auto next=nextToken();
+        if (!next.has_value())
+            return std::make_optional<CompilationError>(_current_pos, ErrorCode::ErrFunctionDefinition);
 
         int hasConst = 0;
         if (next.value().GetType() == TokenType::CONST) {
@@ -1217,20 +1249,20 @@ namespace miniplc0 {
             auto err = analyseExpressionList();
             if (err.second.has_value())
                 return std::make_pair(std::optional<Analyser::FunCall*>(), err.second);
-            exps = err.first.value();
+            exps = std::move(err.first.value());
             next = nextToken();
             if(!next.has_value() || next.value().GetType() != TokenType::RIGHT_BRACKET){
                 return std::make_pair(std::optional<Analyser::FunCall*>(),
                                       std::make_optional<CompilationError>(_current_pos, ErrorCode::ErrFunctionCall));
             }
-            return std::make_pair(new FunCall(NULL_TOKEN, function, exps, index), std::optional<CompilationError>());
+            return std::make_pair(_arena.Make<FunCall>(NULL_TOKEN, function, std::move(exps), index), std::optional<CompilationError>());
         }
 
         if (function.getParaSize() != 0)
             return std::make_pair(std::optional<Analyser::FunCall*>(),
                                   std::make_optional<CompilationError>(_current_pos,
                                                                        ErrorCode::ErrFunctionCall));
-        return std::make_pair(new FunCall(NULL_TOKEN, function, exps, index), std::optional<CompilationError>());
+        return std::make_pair(_arena.Make<FunCall>(NULL_TOKEN, function, std::move(exps), index), std::optional<CompilationError>());
 
     }
 
@@ -1253,7 +1285,7 @@ namespace miniplc0 {
             // 预读 判断是否正常结束匹配
             auto next = nextToken();
             if (!next.has_value())
-                return {};
+                return std::make_pair(exprs, std::optional<CompilationError>());
 
             // 有token，必定有值，只需要判断是不是 ','
             // 如果不是','，可能匹配下一条语句，回退返回
@@ -1275,36 +1307,59 @@ namespace miniplc0 {
     }
 
 	std::optional<Token> Analyser::nextToken() {
-		if (_offset == _tokens.size())
-			return {};
-		// 考虑到 _tokens[0..._offset-1] 已经被分析过了
-		// 所以我们选择 _tokens[0..._offset-1] 的 EndPos 作为当前位置
-		_current_pos = _tokens[_offset].GetEndPos();
-		return _tokens[_offset++];
+		if (_stream != nullptr) {
+			if (_offset == _stream->size())
+				return {};
+			// 考虑到 token[0..._offset-1] 已经被分析过了
+			// 所以我们选择 token[0..._offset-1] 的 EndPos 作为当前位置
+			_current_pos = SourcePos{ &_stream->Source(), _stream->EndOffset(_offset) };
+			return (*_stream)[_offset++];
+		}
+		// 窗口里没有回退过的 token 了，从词法分析器取一个新的
+		if (_offset == _read) {
+			auto tk = pullToken();
+			if (!tk.has_value())
+				return {};
+			if (_window.size() < _window_size)
+				_window.push_back(tk.value());
+			else
+				_window[_read % _window_size] = tk.value();
+			_read++;
+		}
+		auto& tk = _window[_offset % _window_size];
+		_current_pos = SourcePos{ _tokenizer->Source(), tk.GetEndOffset() };
+		_offset++;
+		return tk;
 	}
 
 	void Analyser::unreadToken() {
 		if (_offset == 0)
 			DieAndPrint("analyser unreads token from the begining.");
-		_current_pos = _tokens[_offset - 1].GetEndPos();
+		if (_stream != nullptr) {
+			_current_pos = SourcePos{ &_stream->Source(), _stream->EndOffset(_offset - 1) };
+			_offset--;
+			return;
+		}
+		if (_read - _offset >= _window_size)
+			DieAndPrint("analyser unreads token beyond the lookahead window.");
+		_current_pos = SourcePos{ _tokenizer->Source(), _window[(_offset - 1) % _window_size].GetEndOffset() };
 		_offset--;
 	}
 
+	std::optional<Token> Analyser::pullToken() {
+		if (_token_error.has_value())
+			return {};
+		auto p = _tokenizer->NextToken();
+		if (p.second.has_value()) {
+			if (p.second.value().GetCode() != ErrorCode::ErrEOF)
+				_token_error = p.second;
+			return {};
+		}
+		return p.first;
+	}
 
-    //常量表、函数表操作
-    void Analyser::addCONST(const Token &tk) {
-        if (tk.GetType() == TokenType::IDENTIFIER) {
-            std::string str = tk.GetValueString();
-            _CONSTS.push_back(make_pair(str, 1));
-            _constant[str] = _CONSTS.size();
-        }else if (tk.GetType() == TokenType::UNSIGNED_INTEGER || tk.GetType() == TokenType::UNSIGNED_HEX_INTEGER) {
-            std::string str = tk.GetValueString();
-            _CONSTS.push_back(make_pair(str, 0));
-            _constant[str] = _CONSTS.size();
-        }
-
-    }
 
+    //常量表、函数表操作
     bool Analyser::isFunctionDeclared(const std::string &s) {
         if(_function.size()==0){
             return false;
@@ -1313,22 +1368,12 @@ namespace miniplc0 {
     }
 
     void Analyser::addFunction(std::string name, int level, std::vector<TokenType> &paras, TokenType &ret) {
-        int nameindex = getConstIndex(Token(TokenType::IDENTIFIER, name));
+        int nameindex = _consts.String(name);
         Function f(nameindex, level, paras, ret);
         _funcs.emplace_back(f);
         _function[name] = _funcs.size();
     }
 
-    int32_t Analyser::getConstIndex(const Token &tk) {
-        if (tk.GetType() == TokenType::IDENTIFIER)//string
-        {
-            return _constant[tk.GetValueString()] - 1;
-        } else if (tk.GetType() == TokenType::UNSIGNED_HEX_INTEGER || tk.GetType() == TokenType::UNSIGNED_INTEGER) {
-            std::string s=tk.GetValueString();
-            return _constant[s] - 1;
-        }
-    }
-
     int32_t Analyser::getFuncIndex(const std::string &s) {
         return _function[s];
     }
@@ -1337,124 +1382,77 @@ namespace miniplc0 {
         return _funcs[index - 1];
     }
 
-    bool Analyser::checkState(Token &token) {
-        std::string s;
-        s = token.GetValueString();
-        return isCONST(s);
-
-    }
-
-    bool Analyser::isCONST(std::string basicString) {
-        return _constant[basicString] != 0;
-    }
-
     //变量表
 
     bool Analyser::isDeclared(const std::string &s) {
-        return _findLocal(s).getIndex() != 0 || _findGlobal(s).getIndex() != 0;
+        return _symbols.FindLocal(s).getIndex() != 0 || _symbols.FindGlobal(s).getIndex() != 0;
     }
 
     bool Analyser::checkDeclare(const std::string &s) {
         if (isGlabol == true) {
-            return _findGlobal(s).getIndex() == 0;
+            return _symbols.FindGlobal(s).getIndex() == 0;
         } else {
-            return _find(s, *_var).getIndex() == 0;
+            return !_symbols.DeclaredInScope(s);
         }
     }
 
-    bool Analyser::isConstant(const std::string &s) {//0
-        auto p = _findLocal(s);
-        auto g = _findGlobal(s);
-        return (p.getIndex() != 0 && p.isConst1()) && (g.getIndex() != 0 && g.isConst1());
+    // 看当前可见的那个声明，局部量会遮住同名的全局量
+    bool Analyser::isConstant(const std::string &s) {
+        auto var = getVar(s);
+        return var.getIndex() != 0 && var.isConst1();
     }
 
-    //底层操作，添加，查找
-    void Analyser::_add(const Token &tk, std::map<std::string, Var> &sk, const TokenType &type, const bool &isConst,
-                        const bool &isUnit) {
+    //底层操作，添加
+    void Analyser::_add(const Token &tk, const TokenType &type, const bool &isConst, const bool &isUnit) {
         if (tk.GetType() != TokenType::IDENTIFIER)
             DieAndPrint("only identifier can be added to the table.");
-        std::string s = tk.GetValueString();
         if (isGlabol == false)
-            sk[s] = Var(++_nextTokenIndex, type, isConst, isUnit, false);
+            _symbols.DeclareLocal(tk.GetText(), Var(++_nextTokenIndex, type, isConst, isUnit, false));
         else
-            sk[s] = Var(++_nextGTokenIndex, type, isConst, isUnit, true);
-    }
-
-    Var Analyser::_find(const std::string &s, std::map<std::string, Var> &sk) {
-        return sk[s];
-    }
-
-    Var Analyser::_findLocal(const std::string &s) {
-        if (_find(s, *_var).getIndex() != 0)
-            return _find(s, *_var);
-        for (int i = _var_table.size() - 1; i >= 0; i--) {
-            if (_find(s, (*(_var_table[i]))).getIndex() != 0)
-                return _find(s, (*(_var_table[i])));
-        }
-        return Var();
-    }
-
-    Var Analyser::_findGlobal(const std::string &s) {
-        if (_find(s, (g_var)).getIndex() != 0)
-            return _find(s, (g_var));
-        return Var();
+            _symbols.DeclareGlobal(tk.GetText(), Var(++_nextGTokenIndex, type, isConst, isUnit, true));
     }
 
     Var Analyser::getVar(const std::string &s) {
-        auto var = _findLocal(s), gvar = _findGlobal(s);
+        auto var = _symbols.FindLocal(s);
         if (var.getIndex() != 0)
             return var;
-        if (gvar.getIndex() != 0)
-            return gvar;
-        return Var();
+        return _symbols.FindGlobal(s);
     }
 
     //添加变量、常量、未初始化变量
     void Analyser::addVariable(const Token &tk, const TokenType &type) {
-        if (isGlabol == true)
-            _add(tk, g_var, type, false, false);
-        else
-            _add(tk, (*_var), type, false, false);
+        _add(tk, type, false, false);
     }
 
     void Analyser::addConstant(const Token &tk, const TokenType &type) {
-        if (isGlabol == true)
-            _add(tk, g_var, type, true, false);
+        _add(tk, type, true, false);
+    }
+
+    void Analyser::addConstant(const Token &tk, const TokenType &type, int32_t value) {
+        if (tk.GetType() != TokenType::IDENTIFIER)
+            DieAndPrint("only identifier can be added to the table.");
+        if (isGlabol == false)
+            _symbols.DeclareLocal(tk.GetText(), Var(type, value, false));
         else
-            _add(tk, (*_var), type, true, false);
+            _symbols.DeclareGlobal(tk.GetText(), Var(type, value, true));
     }
 
     void Analyser::addUninitializedVariable(const Token &tk, const TokenType &type) {
-        if (isGlabol == true)
-            _add(tk, g_var, type, false, true);
-        else
-            _add(tk, (*_var), type, false, true);
+        _add(tk, type, false, true);
     }
 
+    // 进入新的作用域（函数体或者语句块）
     void Analyser::pushStack() {
-        _var_table.emplace_back(_var);
-        _var = new std::map<std::string, Var>();
+        _symbols.PushScope();
     }
 
+    // 退出作用域，恢复被遮住的同名变量
     void Analyser::popStack() {
-        (*_var).clear();
-        _var = _var_table.back();
-        _var_table.pop_back();
-    }
-
-    void Analyser::createStack() {
-	    // 程序开始创建第一个栈帧
-        _var = new std::map<std::string, Var>();
+        _symbols.PopScope();
     }
 
     int32_t Analyser::getVarsNum()
     {
-        int num=0;
-        for(auto it :*_var)
-        {
-            if(it.second.getIndex()!=0)
-                num++;
-        }
-        return num;
+        return static_cast<int32_t>(_symbols.ScopeSize());
     }
-}
\ No newline at end of file
+}
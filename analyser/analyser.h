@@ -2,7 +2,13 @@
 
 #include "error/error.h"
 #include "instruction/instruction.h"
+#include "instruction/label.hpp"
+#include "analyser/arena.hpp"
+#include "analyser/constant_pool.h"
+#include "analyser/fold.hpp"
+#include "analyser/symbol_table.h"
 #include "tokenizer/token.h"
+#include "tokenizer/tokenizer.h"
 
 #include <vector>
 #include <optional>
@@ -12,28 +18,6 @@
 #include <cstddef> // for std::size_t
 
 namespace miniplc0 {
-    extern std::vector<miniplc0::Instruction> _instructions;
-
-    class Var {
-        public:
-            Var(int32_t index, TokenType type, bool isConst, bool isUnit, bool isGlobal) : _index(index), _type(type),
-                                                                                           isConst(isConst), isUnit(isUnit),
-                                                                                           isGlobal(isGlobal) {}
-            Var(){_type=TokenType ::LEFT_BRACE;_index=0;}
-        private:
-            int32_t _index;
-            TokenType _type;
-            bool isConst;
-            bool isUnit;
-            bool isGlobal;
-        public:
-            bool isGlobal1() const {return isGlobal;}
-            bool isConst1() const {return isConst;}
-        public:
-            int32_t getIndex() const {return _index;}
-            TokenType getType() const {return _type;}
-    };
-
     class Function{
         public:
             Function(int nameindex, int level, const std::vector<TokenType> &paras, TokenType ret) : nameindex(nameindex),
@@ -46,23 +30,28 @@ namespace miniplc0 {
             std::vector<TokenType> paras;
             TokenType ret;
             TokenType getRet() const {return ret;}
-            int32_t getParaSize(){return paras.size();}
+            int32_t getParaSize() const {return paras.size();}
             const std::vector<TokenType> &getParas() const {return paras;}
     };
 
+    struct OptimizeReport;
+
+    // 访问函数都返回常引用，需要副本时由调用者自己复制
     class Program{
         public:
-            Program(std::vector<std::pair<std::string,int>> _CONSTS,std::vector<Function> _funcs,std::vector<std::vector<Instruction>> _program):
-                    _CONSTS(_CONSTS),_funcs(_funcs),_program(_program){}
+            Program(std::vector<Constant> _CONSTS,std::vector<Function> _funcs,std::vector<std::vector<Instruction>> _program):
+                    _CONSTS(std::move(_CONSTS)),_funcs(std::move(_funcs)),_program(std::move(_program)){}
             Program(){}
-            std::vector<std::pair<std::string,int>> cons(){
+            const std::vector<Constant> &cons() const {
                 return _CONSTS;
             }
-            std::vector<Function> funcs(){return _funcs;}
-            std::vector<Instruction> start(){return _program[0];}
-            std::vector<std::vector<Instruction>> codes(){return _program;}
+            const std::vector<Function> &funcs() const {return _funcs;}
+            const std::vector<Instruction> &start() const {return _program[0];}
+            const std::vector<std::vector<Instruction>> &codes() const {return _program;}
         private:
-            std::vector<std::pair<std::string,int>> _CONSTS;
+            // 优化直接改写生成的代码，见 optimizer/optimizer.h
+            friend OptimizeReport Optimize(Program& program, int level);
+            std::vector<Constant> _CONSTS;
             std::vector<Function> _funcs;
             std::vector<std::vector<Instruction>> _program;
     };
@@ -74,18 +63,32 @@ namespace miniplc0 {
             using uint32_t = std::uint32_t;
             using int32_t = std::int32_t;
         public:
-            Analyser(std::vector<Token> v)
-                    : _tokens(std::move(v)), _offset(0),_program({}), _current_pos(0, 0),
-                      _function({}),_constant({}),_CONSTS({}),_funcs({}),_var(nullptr),
-                      _nextTokenIndex(0),_nextConstIndex(0),_nextFuncIndex(0){}
+            // 分析一个完整的 token 序列，直接在 ts 上取 token，ts 必须比 Analyser 活得久
+            // fold 为 false 时不做常量折叠，每个运算都生成对应的指令
+            Analyser(const TokenStream& ts, bool fold = true) : Analyser(fold) { _stream = &ts; }
             Analyser(Analyser&&) = delete;
             Analyser(const Analyser&) = delete;
             Analyser& operator=(Analyser) = delete;
 
+            // 流式分析：边分析边从 tkz 取 token，只保留最近的几个，tkz 必须比 Analyser 活得久
+            Analyser(Tokenizer& tkz, bool fold = true) : Analyser(fold) { _tokenizer = &tkz; }
+
+            // Analyse 的结果，出错时 program 为空
+            struct Result {
+                Program program;
+                std::optional<CompilationError> error;
+                // 流式分析时 error 来自词法分析，调用者不用在 Analyse 之后再回头问 Analyser
+                bool lexical;
+            };
+
             // 唯一接口
-            std::pair<Program, std::optional<CompilationError>> Analyse();
+            // 左值调用时复制生成的代码，Analyser 里的结果保持不变
+            Result Analyse() &;
+            // 右值调用时把常量表、函数表和代码直接移动到 Program 里：std::move(analyser).Analyse()
+            Result Analyse() &&;
 
 
+            // 表达式结点的 gen 把指令生成到传入的 code 里（一般就是 Analyser 当前函数的 _instructions）
             struct MulItem;
             struct Item;
             struct Expression;
@@ -94,6 +97,9 @@ namespace miniplc0 {
             struct Integer;
             struct Variable;
         private:
+            // 分析整个程序，Analyse 的两个版本只是构造 Program 的方式不同
+            std::optional<CompilationError> analyse();
+
             // 所有的递归子程序
 
             // <程序>
@@ -141,7 +147,8 @@ namespace miniplc0 {
             // <condition-statement>
             std::optional<CompilationError> analyseConditionStatement();
             // <condition>
-            std::pair<std::optional<int32_t >,std::optional<CompilationError>> analyseCondition();
+            // 条件不成立时跳转到标号 label
+            std::optional<CompilationError> analyseCondition(int32_t label);
             // <loop-statement>
             std::optional<CompilationError> analyseLoopStatement();
             // <scan-statement>
@@ -161,20 +168,33 @@ namespace miniplc0 {
             std::optional<Token> nextToken();
             // 回退一个 token
             void unreadToken();
+            // 流式分析时从词法分析器取下一个 token，不经过回看窗口
+            std::optional<Token> pullToken();
 
         private:
-            std::vector<Token> _tokens;
+            explicit Analyser(bool fold)
+                    : _fold(fold), _stream(nullptr), _offset(0), _current_pos{ nullptr, 0 }, _tokenizer(nullptr), _read(0),
+                      _nextTokenIndex(0),_program({}),_hasConst(0),
+                      _function({}),_funcs({}),
+                      _nextFuncIndex(0),_nextGTokenIndex(0){}
+
+            bool _fold;
+            // token 的来源，两者有且只有一个非空
+            const TokenStream* _stream;
             std::size_t _offset;
-            std::pair<uint64_t, uint64_t> _current_pos;
+            SourcePos _current_pos;
+            Tokenizer* _tokenizer;
+            std::optional<CompilationError> _token_error;
+            // 回看窗口，保存最近取到的 token，_offset 和 _read 都是在整个 token 序列中的下标
+            // 窗口必须能覆盖 unreadToken 连续回退的最大次数（analyseVariableDeclaration 中是 3）
+            static constexpr std::size_t _window_size = 8;
+            std::vector<Token> _window;
+            // 已经取到窗口里的 token 数
+            std::size_t _read;
 
             // 为了简单处理，我们直接把符号表耦合在语法分析里
-            // 变量                   示例
-            // _uninitialized_vars    int a;
-            // _vars                  int a=1;
-            // _consts                const a=1;
-            std::map<std::string, int32_t> _uninitialized_vars;
-            std::map<std::string, int32_t> _vars;
-            std::map<std::string, int32_t> _consts;
+            // 变量和常量（包括未初始化的变量）都在 _symbols 里，用 Var 的属性区分
+            SymbolTable _symbols;
             // 下一个 token 在栈的偏移
             int32_t _nextTokenIndex;
             bool isGlabol;
@@ -182,62 +202,51 @@ namespace miniplc0 {
             // 语义分析与符号表函数
         private:
             std::vector<std::vector<Instruction>> _program;
+            // 当前正在生成的函数（或者全局量初始化）的指令
+            std::vector<Instruction> _instructions;
+            // 正在分析的声明语句是不是 const
+            int _hasConst;
+            // 当前函数中跳转的标号，函数结束时换成指令下标
+            LabelTable _labels;
 
             std::map<std::string, int32_t> _function;
-            std::map<std::string, int32_t> _constant;
-            std::vector<std::pair<std::string,int>> _CONSTS;
+            // 整数字面量和函数名
+            ConstantPool _consts;
             std::vector<Function> _funcs;
             std::vector<TokenType> _paras;
 
             TokenType _funcRetType;
             int32_t _nextFuncIndex;
-            int32_t _nextConstIndex;
             int32_t _nextGTokenIndex;
-            // 代表当前的栈帧
-            std::map<std::string, Var>* _var;
-            std::map<std::string, Var> g_var;//仅做全局变量为空时迭代器所指的地方
-            std::vector<std::string> localVars;
-            std::vector<std::map<std::string, Var>*> _var_table;
+            // 表达式结点都从这里分配，Analyse 结束时一起释放
+            Arena _arena;
 
         private:
 
-            // 栈式符号表管理
-            void createStack();
-
             // 下面是符号表相关操作
 
             // helper function
-            void
-            _add(const Token &, std::map<std::string, Var> &, const TokenType &, const bool &,const bool &);
-            Var _find(const std::string& ,std::map<std::string, Var>& );
-            TokenType getType(std::string& );
-            Var _findLocal(const std::string& );
-            Var _findGlobal(const std::string& );
+            void _add(const Token &, const TokenType &, const bool &,const bool &);
             // 添加变量、常量、未初始化的变量
             //添加函数表 ，返回索引
             void addFunction(std::string ,int  ,std::vector<TokenType>&,TokenType&);
             void addVariable(const Token&,const TokenType&);
             void addConstant(const Token&,const TokenType&);
+            // 编译期知道值的常量，不分配栈上的位置
+            void addConstant(const Token&,const TokenType&,int32_t);
             void addUninitializedVariable(const Token&,const TokenType&);
-            //添加字面量 返回表的索引
-            void addCONST(const Token&);
             // 是否被声明过
             bool isDeclared(const std::string& );
             bool isFunctionDeclared(const std::string& );
             // 是否是常量
             bool isConstant(const std::string& );
 
-            int32_t getConstIndex(const Token&);
             int32_t getFuncIndex(const std::string& );
 
             //符号表管理
             void pushStack();
             void popStack();
 
-            bool checkState(Token &token);
-
-            bool isCONST(std::string basicString);
-
             Function getFunc(int32_t index);
 
             bool checkDeclare(const std::string &s);
@@ -248,20 +257,57 @@ namespace miniplc0 {
             int32_t getVarsNum();
 
         public:
+            // 表达式树在构造时自底向上做常量折叠
+            // 从左边起连续的、只由整数字面量、值已知的常量和 + - * / 组成的部分在编译期求值，生成一条 ipush
+            // 单独的字面量不算，仍然是 loadc
             struct Item { //* /
                 std::vector<MulItem*> mulitems;
                 std::vector<TokenType> mul;
-                Item(const std::vector<MulItem *> &mulitems, const std::vector<TokenType> &mul) : mulitems(mulitems),
-                                                                                                mul(mul) {}
-                TokenType gen(){
-                    if(mul.size()==0) return mulitems[0]->gen();
-                    mulitems[0]->gen();
-                    for(int i=0;i<mul.size();i++){
-                        mulitems[i+1]->gen();
-                        if(mul[i]==DIVISION_SIGN)
-                            _instructions.emplace_back(Operation::IDIV, 0);
-                        else if (mul[i]==MULTIPLICATION_SIGN)
-                            _instructions.emplace_back(Operation::IMUL, 0);
+                // 左边 folded 个因子折叠成了 prefix
+                std::size_t folded;
+                int32_t prefix;
+                // 所有因子都是编译期常量时的值
+                std::optional<int32_t> value;
+                // fold 为 false 时不折叠，value 也总是空的，表达式和常量都不会在编译期求值
+                Item(std::vector<MulItem *> mulitems, std::vector<TokenType> mul, bool fold) : mulitems(std::move(mulitems)),
+                                                                                               mul(std::move(mul)),
+                                                                                               folded(0), prefix(0) {
+                    if(!fold)
+                        return;
+                    auto v = this->mulitems[0]->signedConstant();
+                    if(!v.has_value())
+                        return;
+                    folded = 1;
+                    prefix = v.value();
+                    for(;folded<this->mulitems.size();folded++){
+                        auto r = this->mulitems[folded]->signedConstant();
+                        if(!r.has_value())
+                            break;
+                        if(this->mul[folded-1]==DIVISION_SIGN){
+                            auto q = fold::Div(prefix, r.value());
+                            if(!q.has_value())
+                                break;
+                            prefix = q.value();
+                        }else
+                            prefix = fold::Mul(prefix, r.value());
+                    }
+                    if(folded==this->mulitems.size())
+                        value = prefix;
+                }
+                TokenType gen(std::vector<Instruction> &code){
+                    if(mul.size()==0) return mulitems[0]->gen(code);
+                    std::size_t i = 1;
+                    if(folded>1){
+                        code.emplace_back(Operation::IPUSH, prefix);
+                        i = folded;
+                    }else
+                        mulitems[0]->gen(code);
+                    for(;i<mulitems.size();i++){
+                        mulitems[i]->gen(code);
+                        if(mul[i-1]==DIVISION_SIGN)
+                            code.emplace_back(Operation::IDIV, 0);
+                        else if (mul[i-1]==MULTIPLICATION_SIGN)
+                            code.emplace_back(Operation::IMUL, 0);
                     }
                     return INT;
                 }
@@ -269,54 +315,100 @@ namespace miniplc0 {
             struct MulItem {
                 TokenType  sign;
                 MulItem(TokenType sign) : sign(sign) {}
-                virtual  TokenType gen(){
-                    if(sign==MINUS_SIGN) _instructions.emplace_back(Operation::INEG, 0);
+                // 编译期已知的值，不包括 sign
+                virtual std::optional<int32_t> constant() const {return {};}
+                std::optional<int32_t> signedConstant() const {
+                    auto v = constant();
+                    if(v.has_value() && sign==MINUS_SIGN) return fold::Neg(v.value());
+                    return v;
+                }
+                virtual  TokenType gen(std::vector<Instruction> &code){
+                    if(sign==MINUS_SIGN) code.emplace_back(Operation::INEG, 0);
                     return TokenType::NULL_TOKEN;
                 }
             };
             struct Variable : MulItem {
                 Var var;
                 Variable(TokenType sign, const Var &var) : MulItem(sign), var(var) {}
+                std::optional<int32_t> constant() const {return var.getValue();}
 
-                TokenType gen(){
+                TokenType gen(std::vector<Instruction> &code){
+                    // 没有栈上位置的常量
+                    if(var.getValue().has_value()){
+                        code.emplace_back(Operation::IPUSH, signedConstant().value());
+                        return var.getType();
+                    }
                     int level=var.isGlobal1(),index=var.getIndex()-1;
-                    _instructions.emplace_back(Operation::LOADA, level, index);
-                    _instructions.emplace_back(Operation::ILOAD, 0);
-                    MulItem::gen();
+                    code.emplace_back(Operation::LOADA, level, index);
+                    code.emplace_back(Operation::ILOAD, 0);
+                    MulItem::gen(code);
                     return var.getType();
                 }
             };
             struct Integer : MulItem {
                 int32_t index;
+                int32_t value;
 
-                Integer(TokenType sign, int32_t index) : MulItem(sign),  index(index) {}
+                Integer(TokenType sign, int32_t index, int32_t value) : MulItem(sign),  index(index), value(value) {}
+                std::optional<int32_t> constant() const {return value;}
 
-                TokenType gen(){
-                    _instructions.emplace_back(Operation::LOADC, index);
-                    MulItem::gen();
+                TokenType gen(std::vector<Instruction> &code){
+                    code.emplace_back(Operation::LOADC, index);
+                    MulItem::gen(code);
                     return TokenType::UNSIGNED_INTEGER;
                 }
             };
             struct Expression : MulItem {
                 std::vector<TokenType> add;
                 std::vector<Item> items;
-                Expression(TokenType sign, const std::vector<TokenType> &add, const std::vector<Item > &items) : MulItem(
-                        sign), add(add), items(items) {}
+                // 左边 folded 个项折叠成了 prefix，不包括 sign
+                std::size_t folded;
+                int32_t prefix;
+                // 所有项都是编译期常量时的值
+                std::optional<int32_t> value;
+                Expression(TokenType sign, std::vector<TokenType> add, std::vector<Item> items) : MulItem(
+                        sign), add(std::move(add)), items(std::move(items)), folded(0), prefix(0) {
+                    for(;folded<this->items.size();folded++){
+                        auto &r = this->items[folded].value;
+                        if(!r.has_value())
+                            break;
+                        if(folded==0)
+                            prefix = r.value();
+                        else if(this->add[folded-1]==MINUS_SIGN)
+                            prefix = fold::Sub(prefix, r.value());
+                        else
+                            prefix = fold::Add(prefix, r.value());
+                    }
+                    if(folded==this->items.size())
+                        value = prefix;
+                }
+                std::optional<int32_t> constant() const {return value;}
 
-                TokenType  gen(){
+                TokenType  gen(std::vector<Instruction> &code){
+                    // 整个表达式都是常量时连同 sign 一起折叠，但括号里单独的字面量 (k) 仍然交给 Integer
+                    if(value.has_value() && (add.size()>0 || sign==MINUS_SIGN)){
+                        code.emplace_back(Operation::IPUSH, signedConstant().value());
+                        return INT;
+                    }
                     if(items.size()==1){
-                        MulItem::gen();
-                        return items[0].gen();
+                        auto type = items[0].gen(code);
+                        MulItem::gen(code);
+                        return type;
                     }
-                    items[0].gen();
-                    for(int i=0;i<add.size();i++){
-                        items[i+1].gen();
-                        if(add[i]==MINUS_SIGN)
-                            _instructions.emplace_back(Operation::ISUB, 0);
-                        else if (add[i]==PLUS_SIGN)
-                            _instructions.emplace_back(Operation::IADD, 0);
+                    std::size_t i = 1;
+                    if(folded>1){
+                        code.emplace_back(Operation::IPUSH, prefix);
+                        i = folded;
+                    }else
+                        items[0].gen(code);
+                    for(;i<items.size();i++){
+                        items[i].gen(code);
+                        if(add[i-1]==MINUS_SIGN)
+                            code.emplace_back(Operation::ISUB, 0);
+                        else if (add[i-1]==PLUS_SIGN)
+                            code.emplace_back(Operation::IADD, 0);
                     }
-                    MulItem::gen();
+                    MulItem::gen(code);
                     return INT;
                 }
             };
@@ -325,15 +417,15 @@ namespace miniplc0 {
                 std::vector<Expression*> exps;
                 int index;
                 FunCall(TokenType sign, const Function &function,
-                        const std::vector<Expression *> &exps) : MulItem(sign),
-                        function(function),exps(exps) {}
-                FunCall(TokenType sign, const Function &function, const std::vector<Expression *> &exps, int index) : MulItem(
-                        sign), function(function), exps(exps), index(index) {}
-                TokenType gen(){
+                        std::vector<Expression *> exps) : MulItem(sign),
+                        function(function),exps(std::move(exps)) {}
+                FunCall(TokenType sign, const Function &function, std::vector<Expression *> exps, int index) : MulItem(
+                        sign), function(function), exps(std::move(exps)), index(index) {}
+                TokenType gen(std::vector<Instruction> &code){
                     auto para=function.getParas();
-                    for(int i=0;i<exps.size();i++) auto type = exps[i]->gen();
-                    MulItem::gen();
-                    _instructions.emplace_back(Operation::CALL,index);
+                    for(int i=0;i<exps.size();i++) auto type = exps[i]->gen(code);
+                    code.emplace_back(Operation::CALL,index);
+                    MulItem::gen(code);
                     return function.getRet();
                 }
             };
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace miniplc0 {
+
+    // 表达式结点的区域分配器
+    // 1.内存按块申请，每次分配只是移动指针
+    // 2.结点不能单独释放，Release 按分配的逆序一次性析构所有结点，只留下第一块内存复用
+    // 3.析构函数不是平凡的结点（带 std::vector 的）会记下来，Release 时调用
+    class Arena final {
+    public:
+        Arena() : _ptr(nullptr), _end(nullptr) {}
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+        ~Arena() { Release(); }
+
+        template<typename T, typename... Args>
+        T* Make(Args&&... args) {
+            T* obj = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            if (!std::is_trivially_destructible<T>::value)
+                _dtors.push_back(Dtor{ obj, [](void* p) { static_cast<T*>(p)->~T(); } });
+            return obj;
+        }
+
+        // 第一块留下来给之后的分配复用，其余的块归还
+        void Release() {
+            for (auto it = _dtors.rbegin(); it != _dtors.rend(); ++it)
+                it->destroy(it->obj);
+            _dtors.clear();
+            if (_blocks.empty())
+                return;
+            _blocks.resize(1);
+            _ptr = _blocks.front().get();
+            _end = _ptr + _block_size;
+        }
+    private:
+        void* allocate(std::size_t size, std::size_t align) {
+            auto p = alignUp(_ptr, align);
+            if (p == nullptr || p > _end || size > static_cast<std::size_t>(_end - p)) {
+                // 特别大的结点单独占一块
+                auto n = std::max(_block_size, size + align);
+                _blocks.emplace_back(new char[n]);
+                _ptr = _blocks.back().get();
+                _end = _ptr + n;
+                p = alignUp(_ptr, align);
+            }
+            _ptr = p + size;
+            return p;
+        }
+
+        static char* alignUp(char* p, std::size_t align) {
+            auto v = reinterpret_cast<std::uintptr_t>(p);
+            return reinterpret_cast<char*>((v + align - 1) & ~static_cast<std::uintptr_t>(align - 1));
+        }
+    private:
+        static constexpr std::size_t _block_size = 64 * 1024;
+
+        struct Dtor {
+            void* obj;
+            void (*destroy)(void*);
+        };
+
+        std::vector<std::unique_ptr<char[]>> _blocks;
+        char* _ptr;
+        char* _end;
+        std::vector<Dtor> _dtors;
+    };
+}
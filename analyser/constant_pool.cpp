@@ -0,0 +1,82 @@
+#include "analyser/constant_pool.h"
+
+namespace miniplc0 {
+
+    namespace {
+        // 类型参与散列，整数和字符串的散列值互不相关
+        std::size_t hashConstant(int type, std::string_view str, int32_t value) {
+            std::uint64_t h = 0xcbf29ce484222325ULL ^ static_cast<std::uint64_t>(type);
+            if (type == 0)
+                h ^= static_cast<std::uint32_t>(value) * 0x9E3779B97F4A7C15ULL;
+            else
+                for (auto ch : str) {
+                    h ^= static_cast<unsigned char>(ch);
+                    h *= 0x100000001b3ULL;
+                }
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            return static_cast<std::size_t>(h);
+        }
+    }
+
+    std::size_t ConstantPool::slotOf(int type, std::string_view str, int32_t value, std::size_t hash) const {
+        auto mask = _slots.size() - 1;
+        for (auto i = hash & mask;; i = (i + 1) & mask) {
+            auto id = _slots[i];
+            if (id == _empty)
+                return i;
+            auto& item = _items[id];
+            if (_hashes[id] == hash && item.type == type && (type == 0 ? item.value == value : item.str == str))
+                return i;
+        }
+    }
+
+    void ConstantPool::grow() {
+        std::vector<uint32_t> slots(_slots.size() * 2, _empty);
+        auto mask = slots.size() - 1;
+        for (uint32_t id = 0; id < _items.size(); id++) {
+            auto i = _hashes[id] & mask;
+            while (slots[i] != _empty)
+                i = (i + 1) & mask;
+            slots[i] = id;
+        }
+        _slots.swap(slots);
+    }
+
+    std::uint32_t ConstantPool::insert(int type, std::string_view str, int32_t value) {
+        auto hash = hashConstant(type, str, value);
+        auto i = slotOf(type, str, value, hash);
+        if (_slots[i] != _empty)
+            return _slots[i];
+        auto id = static_cast<uint32_t>(_items.size());
+        _items.push_back(Constant{ type, std::string(str), value });
+        _hashes.push_back(hash);
+        _slots[i] = id;
+        if (_items.size() * 2 > _slots.size())
+            grow();
+        return id;
+    }
+
+    std::uint32_t ConstantPool::Int(int32_t value) {
+        return insert(0, std::string_view(), value);
+    }
+
+    std::uint32_t ConstantPool::String(std::string_view str) {
+        return insert(1, str, 0);
+    }
+
+    std::optional<std::uint32_t> ConstantPool::FindInt(int32_t value) const {
+        auto id = _slots[slotOf(0, std::string_view(), value, hashConstant(0, std::string_view(), value))];
+        if (id == _empty)
+            return {};
+        return id;
+    }
+
+    std::optional<std::uint32_t> ConstantPool::FindString(std::string_view str) const {
+        auto id = _slots[slotOf(1, str, 0, hashConstant(1, str, 0))];
+        if (id == _empty)
+            return {};
+        return id;
+    }
+}
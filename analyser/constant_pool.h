@@ -0,0 +1,53 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace miniplc0 {
+
+    // 常量表中的一项
+    // type 为 0 是整数，值在 value 里；为 1 是字符串（函数名），值在 str 里
+    struct Constant {
+        int type;
+        std::string str;
+        int32_t value;
+    };
+
+    // 常量池
+    // 1.整数和字符串是不同的键，值相同也不会合并（0 和 "0" 是两项）
+    // 2.下标从 0 开始按第一次加入的顺序分配，之后不会改变，同一个常量只占一项
+    // 3.开放寻址（线性探测）的散列表，槽里只存下标，比较时到 _items 里取值
+    // Find* 只查找，不会修改池
+    class ConstantPool final {
+        private:
+            using uint32_t = std::uint32_t;
+        public:
+            ConstantPool() : _slots(16, _empty) {}
+
+            // 返回常量的下标，第一次出现时加到池的末尾
+            uint32_t Int(int32_t value);
+            uint32_t String(std::string_view str);
+            std::optional<uint32_t> FindInt(int32_t value) const;
+            std::optional<uint32_t> FindString(std::string_view str) const;
+
+            std::size_t size() const { return _items.size(); }
+            const std::vector<Constant>& Items() const & { return _items; }
+            std::vector<Constant> Items() && { return std::move(_items); }
+        private:
+            // 常量所在的槽，不存在时是它应该插入的空槽
+            std::size_t slotOf(int type, std::string_view str, int32_t value, std::size_t hash) const;
+            uint32_t insert(int type, std::string_view str, int32_t value);
+            void grow();
+        private:
+            static constexpr uint32_t _empty = UINT32_MAX;
+            // 槽数总是 2 的幂，装载因子不超过 1/2
+            std::vector<uint32_t> _slots;
+            std::vector<Constant> _items;
+            // 每一项的散列值，扩容时不用重新计算
+            std::vector<std::size_t> _hashes;
+    };
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <optional>
+#include <cstdint>
+
+namespace miniplc0 {
+
+    // 常量折叠用到的整数运算，和虚拟机的 32 位补码运算一致
+    // 加、减、乘、取负溢出时回绕，除法向 0 取整
+    namespace fold {
+
+        inline int32_t Add(int32_t a, int32_t b) {
+            return static_cast<int32_t>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b));
+        }
+
+        inline int32_t Sub(int32_t a, int32_t b) {
+            return static_cast<int32_t>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b));
+        }
+
+        inline int32_t Mul(int32_t a, int32_t b) {
+            return static_cast<int32_t>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b));
+        }
+
+        inline int32_t Neg(int32_t a) {
+            return static_cast<int32_t>(0u - static_cast<uint32_t>(a));
+        }
+
+        // 除以 0 和 INT32_MIN / -1 在运行时出错，不折叠，原样留给虚拟机
+        inline std::optional<int32_t> Div(int32_t a, int32_t b) {
+            if (b == 0 || (a == INT32_MIN && b == -1))
+                return {};
+            return a / b;
+        }
+    }
+}
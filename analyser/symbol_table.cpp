@@ -0,0 +1,125 @@
+#include "analyser/symbol_table.h"
+#include "error/error.h"
+
+namespace miniplc0 {
+
+    namespace {
+        // FNV-1a，标识符都很短
+        std::size_t hashName(std::string_view name) {
+            std::uint64_t h = 0xcbf29ce484222325ULL;
+            for (auto ch : name) {
+                h ^= static_cast<unsigned char>(ch);
+                h *= 0x100000001b3ULL;
+            }
+            return static_cast<std::size_t>(h ^ (h >> 32));
+        }
+    }
+
+    std::size_t Interner::slotOf(std::string_view name, std::size_t hash) const {
+        auto mask = _slots.size() - 1;
+        for (auto i = hash & mask;; i = (i + 1) & mask) {
+            auto id = _slots[i];
+            if (id == _empty || (_hashes[id] == hash && _names[id] == name))
+                return i;
+        }
+    }
+
+    void Interner::grow() {
+        std::vector<uint32_t> slots(_slots.size() * 2, _empty);
+        auto mask = slots.size() - 1;
+        for (uint32_t id = 0; id < _names.size(); id++) {
+            auto i = _hashes[id] & mask;
+            while (slots[i] != _empty)
+                i = (i + 1) & mask;
+            slots[i] = id;
+        }
+        _slots.swap(slots);
+    }
+
+    std::uint32_t Interner::Intern(std::string_view name) {
+        auto hash = hashName(name);
+        auto i = slotOf(name, hash);
+        if (_slots[i] != _empty)
+            return _slots[i];
+        auto id = static_cast<uint32_t>(_names.size());
+        _names.emplace_back(name);
+        _hashes.push_back(hash);
+        _slots[i] = id;
+        if (_names.size() * 2 > _slots.size())
+            grow();
+        return id;
+    }
+
+    std::optional<std::uint32_t> Interner::Find(std::string_view name) const {
+        auto id = _slots[slotOf(name, hashName(name))];
+        if (id == _empty)
+            return {};
+        return id;
+    }
+
+    std::uint32_t SymbolTable::intern(std::string_view name) {
+        auto id = _names.Intern(name);
+        if (id >= _locals.size()) {
+            _locals.resize(_names.size(), Binding{ Var(), 0 });
+            _globals.resize(_names.size());
+        }
+        return id;
+    }
+
+    void SymbolTable::DeclareGlobal(std::string_view name, const Var& var) {
+        _globals[intern(name)] = var;
+    }
+
+    void SymbolTable::DeclareLocal(std::string_view name, const Var& var) {
+        if (_marks.empty())
+            DieAndPrint("declaring a local variable outside any scope.");
+        auto id = intern(name);
+        _undo.emplace_back(id, _locals[id]);
+        _locals[id] = Binding{ var, _marks.size() };
+    }
+
+    Var SymbolTable::FindLocal(std::string_view name) const {
+        auto id = _names.Find(name);
+        if (!id.has_value())
+            return Var();
+        return _locals[id.value()].var;
+    }
+
+    Var SymbolTable::FindGlobal(std::string_view name) const {
+        auto id = _names.Find(name);
+        if (!id.has_value())
+            return Var();
+        return _globals[id.value()];
+    }
+
+    bool SymbolTable::DeclaredInScope(std::string_view name) const {
+        auto id = _names.Find(name);
+        if (!id.has_value())
+            return false;
+        auto& b = _locals[id.value()];
+        return b.var.getIndex() != 0 && b.depth == _marks.size();
+    }
+
+    void SymbolTable::PushScope() {
+        _marks.push_back(_undo.size());
+    }
+
+    void SymbolTable::PopScope() {
+        if (_marks.empty())
+            DieAndPrint("popping a scope that was never pushed.");
+        for (auto n = _marks.back(); _undo.size() > n; _undo.pop_back())
+            _locals[_undo.back().first] = _undo.back().second;
+        _marks.pop_back();
+    }
+
+    std::size_t SymbolTable::ScopeSize() const {
+        if (_marks.empty())
+            return 0;
+        // 同一个作用域里不会重复声明，日志里每个编号当前的绑定就是这个作用域里的声明
+        std::size_t n = 0;
+        for (auto i = _marks.back(); i < _undo.size(); i++)
+            if (_locals[_undo[i].first].var.hasSlot())
+                n++;
+        return n;
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "tokenizer/token.h"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace miniplc0 {
+
+    class Var {
+        public:
+            Var(int32_t index, TokenType type, bool isConst, bool isUnit, bool isGlobal) : _index(index), _type(type),
+                                                                                           isConst(isConst), isUnit(isUnit),
+                                                                                           isGlobal(isGlobal) {}
+            // 编译期知道值的常量，不占栈上的位置
+            Var(TokenType type, int32_t value, bool isGlobal) : _index(-1), _type(type), isConst(true), isUnit(false),
+                                                                isGlobal(isGlobal), _value(value) {}
+            Var(){_type=TokenType ::LEFT_BRACE;_index=0;}
+        private:
+            // 栈上的位置加 1，0 表示没找到，-1 表示没有位置
+            int32_t _index;
+            TokenType _type;
+            bool isConst;
+            bool isUnit;
+            bool isGlobal;
+            std::optional<int32_t> _value;
+        public:
+            bool isGlobal1() const {return isGlobal;}
+            bool isConst1() const {return isConst;}
+        public:
+            int32_t getIndex() const {return _index;}
+            TokenType getType() const {return _type;}
+            bool hasSlot() const {return _index > 0;}
+            std::optional<int32_t> getValue() const {return _value;}
+    };
+
+    // 标识符驻留：每个不同的名字对应一个从 0 开始的连续编号
+    // 开放寻址（线性探测）的散列表，槽里只存编号，比较时到 _names 里取名字
+    class Interner final {
+        private:
+            using uint32_t = std::uint32_t;
+        public:
+            Interner() : _slots(16, _empty) {}
+
+            // 返回 name 的编号，第一次出现时分配新编号
+            uint32_t Intern(std::string_view name);
+            // 只查找，不存在时返回空，不会修改表
+            std::optional<uint32_t> Find(std::string_view name) const;
+
+            std::size_t size() const { return _names.size(); }
+            const std::string& Name(uint32_t id) const { return _names[id]; }
+        private:
+            // name 所在的槽，不存在时是它应该插入的空槽
+            std::size_t slotOf(std::string_view name, std::size_t hash) const;
+            void grow();
+        private:
+            static constexpr uint32_t _empty = UINT32_MAX;
+            // 槽数总是 2 的幂，装载因子不超过 1/2
+            std::vector<uint32_t> _slots;
+            std::vector<std::string> _names;
+            // 每个编号的散列值，扩容时不用重新计算
+            std::vector<std::size_t> _hashes;
+    };
+
+    // 作用域符号表
+    // 每个标识符编号只保存当前可见的局部量和全局量，查找只是一次数组访问，和作用域的嵌套深度无关
+    // 声明局部量时把被它遮住的旧绑定记进撤销日志，退出作用域时按日志逆序恢复
+    // 查找不到时返回 getIndex() 为 0 的 Var，并且不会修改任何状态
+    class SymbolTable final {
+        public:
+            void DeclareGlobal(std::string_view name, const Var& var);
+            void DeclareLocal(std::string_view name, const Var& var);
+
+            // 所有局部作用域中最内层的同名局部量
+            Var FindLocal(std::string_view name) const;
+            Var FindGlobal(std::string_view name) const;
+            // name 是否在最内层的局部作用域中声明过
+            bool DeclaredInScope(std::string_view name) const;
+
+            void PushScope();
+            void PopScope();
+            // 最内层的局部作用域中占栈上位置的声明个数
+            std::size_t ScopeSize() const;
+        private:
+            struct Binding {
+                Var var;
+                // 声明所在的作用域深度
+                std::size_t depth;
+            };
+            std::uint32_t intern(std::string_view name);
+        private:
+            Interner _names;
+            // 都按标识符编号下标
+            std::vector<Binding> _locals;
+            std::vector<Var> _globals;
+            // <编号, 被遮住的旧绑定>
+            std::vector<std::pair<std::uint32_t, Binding>> _undo;
+            // 每个作用域开始时 _undo 的长度，_marks.size() 就是当前深度
+            std::vector<std::size_t> _marks;
+    };
+}
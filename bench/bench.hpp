@@ -0,0 +1,63 @@
+#pragma once
+
+#include "tokenizer/source.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+// 基准程序共用的小工具
+// 这些程序只输出数字，不做判断，构建时生成但不注册到 ctest
+namespace bench {
+
+    // 运行 fn reps 次，返回最快一次的毫秒数
+    template<typename F>
+    double Best(int reps, F&& fn) {
+        double best = 1e300;
+        for (int i = 0; i < reps; i++) {
+            auto t0 = std::chrono::steady_clock::now();
+            fn();
+            auto t1 = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+        }
+        return best;
+    }
+
+    inline miniplc0::SourceBuffer FromString(const std::string& text) {
+        std::istringstream is(text);
+        return miniplc0::SourceBuffer::FromStream(is);
+    }
+
+    // 命令行给了文件就用文件，否则用 fallback 生成的源码
+    template<typename F>
+    miniplc0::SourceBuffer Input(int argc, char** argv, F&& fallback) {
+        if (argc > 1) {
+            auto src = miniplc0::SourceBuffer::FromFile(argv[1]);
+            if (!src.has_value()) {
+                std::fprintf(stderr, "Fail to open %s for reading.\n", argv[1]);
+                std::exit(2);
+            }
+            return std::move(src.value());
+        }
+        return FromString(fallback());
+    }
+
+    // 大约 bytes 字节的合法 C0 程序，各种 token 都有
+    inline std::string Program(std::size_t bytes) {
+        std::string s = "const int N = 0x7fff;\nint g = 42;\n";
+        for (std::size_t i = 0; s.size() < bytes; i++) {
+            auto n = std::to_string(i);
+            s += "int f" + n + "(int a, const int b) {\n"
+                 "    int x = a * 3 + b / 7 - 0x1f, y;\n"
+                 "    /* block comment */\n"
+                 "    while (x <= N) { x = x + " + n + "; if (x != b) { print(x, y); } else y = -x; }\n"
+                 "    // line comment\n"
+                 "    return x - g;\n"
+                 "}\n";
+        }
+        return s + "int main() { return 0; }\n";
+    }
+}
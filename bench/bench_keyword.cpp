@@ -0,0 +1,52 @@
+#include "bench/bench.hpp"
+#include "tokenizer/keyword.hpp"
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace miniplc0;
+
+namespace {
+    // 原来的做法：按顺序和每个关键字比较一遍
+    TokenType linearLookup(std::string_view s) {
+        for (auto& k : keyword::table)
+            if (k.name == s)
+                return k.type;
+        return IDENTIFIER;
+    }
+
+    // 关键字和各种长度的标识符混在一起，大约一半是关键字
+    std::vector<std::string> words(std::size_t n) {
+        const char* idents[] = { "i", "x", "main", "count", "intx", "whilst", "returned", "f123", "printer", "scanf",
+                                 "doit", "elsewhere", "a_very_long_identifier_name", "N", "cons", "voids" };
+        std::vector<std::string> r;
+        r.reserve(n);
+        for (std::size_t i = 0; i < n; i++) {
+            if (i % 2 == 0)
+                r.emplace_back(keyword::table[(i / 2) % keyword::count].name);
+            else
+                r.emplace_back(idents[(i / 2) % (sizeof(idents) / sizeof(idents[0]))]);
+        }
+        return r;
+    }
+
+    template<typename F>
+    void run(const char* name, const std::vector<std::string>& ws, F&& lookup) {
+        unsigned long sink = 0;
+        auto ms = bench::Best(5, [&] {
+            for (auto& w : ws)
+                sink += lookup(std::string_view(w));
+        });
+        std::printf("%-8s %8zu words %8.2f ms %7.2f ns/word (checksum %lu)\n", name, ws.size(), ms, ms * 1e6 / ws.size(), sink);
+    }
+}
+
+// 关键字/标识符判别的微基准：编译期完美哈希和逐个比较
+int main() {
+    auto ws = words(4 << 20);
+    run("hash", ws, [](std::string_view s) { return KeywordOrIdentifier(s); });
+    run("linear", ws, [](std::string_view s) { return linearLookup(s); });
+    return 0;
+}
@@ -0,0 +1,21 @@
+#include "bench/bench.hpp"
+#include "tokenizer/tokenizer.h"
+
+#include <cstdio>
+
+// 两种词法分析实现的吞吐量
+// 用法：bench_lexer [file]，没有文件时分析生成的 5MB 程序
+int main(int argc, char** argv) {
+    using namespace miniplc0;
+    auto src = bench::Input(argc, argv, [] { return bench::Program(5 << 20); });
+    for (auto engine : { SWITCH_LEXER, TABLE_LEXER }) {
+        std::size_t n = 0;
+        auto ms = bench::Best(5, [&] {
+            auto p = Tokenizer(src, engine).AllTokenStream();
+            n = p.first.size();
+        });
+        std::printf("%-6s %8zu tokens %8.2f ms %6.2f Mtok/s %7.1f MB/s\n", engine == SWITCH_LEXER ? "switch" : "table",
+                    n, ms, n / ms / 1e3, src.size() / ms / 1e3);
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "bench/bench.hpp"
+#include "tests/vm.hpp"
+#include "analyser/analyser.h"
+#include "optimizer/optimizer.h"
+#include "optimizer/loop.h"
+#include "tokenizer/tokenizer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace miniplc0;
+
+namespace {
+    // bench/loops 和 examples 里有 while 循环的程序，按文件名排序
+    std::vector<std::string> programs() {
+        std::vector<std::string> files;
+        for (auto dir : { "bench/loops", "examples" })
+            for (auto& e : std::filesystem::directory_iterator(std::string(C0_SOURCE_DIR) + "/" + dir))
+                if (e.is_regular_file() && e.path().extension() == ".c0")
+                    files.push_back(e.path().string());
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    bool hasLoop(const std::string& path) {
+        std::ifstream in(path);
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        return text.find("while") != std::string::npos;
+    }
+}
+
+// 循环旋转等 -O1 优化前后，虚拟机执行的指令条数
+// 命令行给了文件就只跑这些文件；scan 读到的输入依次是 5 3 7，之后都是 0
+int main(int argc, char** argv) {
+    std::vector<std::string> files(argv + 1, argv + argc);
+    if (files.empty())
+        files = programs();
+    const std::vector<std::int32_t> input{ 5, 3, 7 };
+    std::uint64_t total0 = 0, totalr = 0, total1 = 0;
+    std::printf("%-16s %5s %12s %12s %7s %12s %7s %9s %9s\n", "program", "loops", "-O0 instrs", "rotated", "saved",
+                "-O1 instrs", "saved", "-O0 ms", "-O1 ms");
+    for (auto& path : files) {
+        if (!hasLoop(path))
+            continue;
+        auto src = SourceBuffer::FromFile(path);
+        if (!src.has_value())
+            continue;
+        Tokenizer tkz(src.value());
+        auto r = Analyser(tkz).Analyse();
+        // examples 里有些程序用了还不支持的语法
+        if (r.error.has_value())
+            continue;
+        auto o0 = std::move(r.program);
+        auto o1 = o0;
+        Optimize(o1, 1);
+        // 只做循环旋转
+        std::size_t loops = 0;
+        auto codes = o0.codes();
+        for (auto& code : codes)
+            loops += RotateLoops(code);
+        Program rotated(o0.cons(), o0.funcs(), std::move(codes));
+
+        test::Run a, b, c;
+        auto ms0 = bench::Best(3, [&] { a = test::Execute(o0, input); });
+        auto ms1 = bench::Best(3, [&] { b = test::Execute(o1, input); });
+        c = test::Execute(rotated, input);
+        if (a.output != b.output || a.error != b.error || a.output != c.output || a.error != c.error) {
+            std::fprintf(stderr, "%s: optimized output differs from -O0.\n", path.c_str());
+            return 1;
+        }
+        total0 += a.executed;
+        totalr += c.executed;
+        total1 += b.executed;
+        std::printf("%-16s %5zu %12llu %12llu %6.1f%% %12llu %6.1f%% %9.2f %9.2f\n", std::filesystem::path(path).filename().string().c_str(),
+                    loops, static_cast<unsigned long long>(a.executed),
+                    static_cast<unsigned long long>(c.executed), 100.0 * (a.executed - c.executed) / a.executed,
+                    static_cast<unsigned long long>(b.executed), 100.0 * (a.executed - b.executed) / a.executed, ms0, ms1);
+    }
+    if (total0 > 0)
+        std::printf("%-16s %5s %12llu %12llu %6.1f%% %12llu %6.1f%%\n", "total", "", static_cast<unsigned long long>(total0),
+                    static_cast<unsigned long long>(totalr), 100.0 * (total0 - totalr) / total0,
+                    static_cast<unsigned long long>(total1), 100.0 * (total0 - total1) / total0);
+    return 0;
+}
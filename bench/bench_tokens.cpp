@@ -0,0 +1,78 @@
+#include "bench/bench.hpp"
+#include "bench/perf.hpp"
+#include "analyser/analyser.h"
+#include "tokenizer/tokenizer.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace miniplc0;
+
+namespace {
+    // 计时的同时数 cache miss，计数器不可用时打印 n/a
+    template<typename F>
+    void run(const char* name, std::size_t tokens, F&& fn) {
+        bench::Counter llc(bench::Event::CacheMisses), l1d(bench::Event::L1dReadMisses);
+        llc.Start();
+        l1d.Start();
+        fn();
+        auto a = llc.Stop();
+        auto b = l1d.Stop();
+        auto ms = bench::Best(5, fn);
+        std::printf("%-22s %8.2f ms %7.2f ns/tok", name, ms, ms * 1e6 / tokens);
+        if (a.has_value() && b.has_value())
+            std::printf("  cache-misses %10llu  L1d-read-misses %10llu\n", static_cast<unsigned long long>(a.value()),
+                        static_cast<unsigned long long>(b.value()));
+        else
+            std::printf("  cache-misses n/a (no hardware counters)\n");
+    }
+}
+
+// TokenStream 和 std::vector<Token> 的内存占用和遍历开销，以及两种语法分析方式的耗时
+// 用法：bench_tokens [file]，没有文件时用生成的 5MB 程序
+// 注意 -s/-c 默认走的是一边词法分析一边语法分析，不经过 TokenStream
+int main(int argc, char** argv) {
+    auto src = bench::Input(argc, argv, [] { return bench::Program(5 << 20); });
+    auto stream = Tokenizer(src).AllTokenStream().first;
+    auto vec = Tokenizer(src).AllTokens().first;
+    auto n = stream.size();
+
+    std::printf("%zu tokens\n", n);
+    std::printf("vector<Token>  %5zu bytes/token %8.1f MB\n", sizeof(Token), n * sizeof(Token) / 1048576.0);
+    constexpr std::size_t column = sizeof(std::uint8_t) + 3 * sizeof(std::uint32_t);
+    std::printf("TokenStream    %5zu bytes/token %8.1f MB\n", column, n * column / 1048576.0);
+
+    // 语法分析器对每个 token 做的事：看类型，偶尔取值和原文长度
+    volatile std::uint64_t sink = 0;
+    run("scan vector<Token>", n, [&] {
+        std::uint64_t s = 0;
+        for (auto& t : vec)
+            s += t.GetType() + static_cast<std::uint32_t>(t.GetIntValue()) + t.GetText().size();
+        sink = s;
+    });
+    run("scan TokenStream", n, [&] {
+        std::uint64_t s = 0;
+        for (std::size_t i = 0; i < n; i++)
+            s += stream.Kind(i) + static_cast<std::uint32_t>(stream.Value(i)) + stream.Length(i);
+        sink = s;
+    });
+    run("analyse TokenStream", n, [&] {
+        Analyser analyser(stream);
+        auto r = analyser.Analyse();
+        sink = r.program.codes().size();
+    });
+    // 和默认路径比较时要算上词法分析
+    run("lex + analyse stream", n, [&] {
+        auto ts = Tokenizer(src).AllTokenStream().first;
+        Analyser analyser(ts);
+        auto r = analyser.Analyse();
+        sink = r.program.codes().size();
+    });
+    run("analyse streaming", n, [&] {
+        Tokenizer tkz(src);
+        Analyser analyser(tkz);
+        auto r = analyser.Analyse();
+        sink = r.program.codes().size();
+    });
+    return 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// 硬件计数器，相当于只数一个事件的 perf stat
+// 只在 Linux 上用 perf_event_open 实现，内核或虚拟机不提供计数器时 Read 返回空
+namespace bench {
+
+    enum class Event { CacheMisses, L1dReadMisses, Instructions };
+
+    class Counter final {
+    public:
+        explicit Counter(Event e) : _fd(-1) {
+#if defined(__linux__)
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            switch (e) {
+                case Event::CacheMisses:
+                    attr.type = PERF_TYPE_HARDWARE;
+                    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                    break;
+                case Event::L1dReadMisses:
+                    attr.type = PERF_TYPE_HW_CACHE;
+                    attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                    break;
+                case Event::Instructions:
+                    attr.type = PERF_TYPE_HARDWARE;
+                    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                    break;
+            }
+            _fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+            (void)e;
+#endif
+        }
+        Counter(const Counter&) = delete;
+        Counter& operator=(const Counter&) = delete;
+        ~Counter() {
+#if defined(__linux__)
+            if (_fd >= 0)
+                close(_fd);
+#endif
+        }
+
+        bool Available() const { return _fd >= 0; }
+
+        void Start() {
+#if defined(__linux__)
+            if (_fd >= 0) {
+                ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+
+        std::optional<std::uint64_t> Stop() {
+#if defined(__linux__)
+            if (_fd < 0)
+                return {};
+            ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+            std::uint64_t n = 0;
+            if (read(_fd, &n, sizeof(n)) != sizeof(n))
+                return {};
+            return n;
+#else
+            return {};
+#endif
+        }
+    private:
+        int _fd;
+    };
+}
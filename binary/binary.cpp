@@ -1,5 +1,5 @@
 #include "binary.h"
-inline void catOp(miniplc0::Instruction &instruction,std::ofstream &out) {
+inline void catOp(const miniplc0::Instruction &instruction,std::ofstream &out) {
     char bytes[32];
     const auto writeNBytes = [&](void* addr, int count) {
         char* p = reinterpret_cast<char*>(addr) + (count-1);
@@ -157,7 +157,7 @@ inline void catOp(miniplc0::Instruction &instruction,std::ofstream &out) {
     writeNBytes(&op, sizeof op);
 }
 
-void Binary(miniplc0::Program &v, std::ofstream &out) {
+void Binary(const miniplc0::Program &v, std::ofstream &out) {
     char bytes[32];
     const auto writeNBytes = [&](void* addr, int count) {
         char* p = reinterpret_cast<char*>(addr) + (count-1);
@@ -172,46 +172,43 @@ void Binary(miniplc0::Program &v, std::ofstream &out) {
     // version
     out.write("\x00\x00\x00\x01", 4);
     // constants_count
-    std::vector<std::pair<std::string, int>> Consts = v.cons();
+    const auto &Consts = v.cons();
     vm::u2 constants_count = Consts.size();
     writeNBytes(&constants_count, sizeof constants_count);
     // constants
     for(int i=0;i<Consts.size();i++)
     {
         int type,length;
-        if(Consts.at(i).second==0)
+        if(Consts.at(i).type==0)
             type=1;//INT
         else
             type=0;//String
         //type 8
         if(type == 0) {
             out.write("\x00", 1);
-            std::string v = Consts.at(i).first;
+            std::string v = Consts.at(i).str;
             vm::u2 len = v.length();
             writeNBytes(&len, sizeof len);
             out.write(v.c_str(), len);
         }else if(type==1){
             out.write("\x01", 1);
-            std::stringstream ss;
-            ss<<Consts.at(i).first;
-            vm::int_t v;
-            ss>>v;
+            vm::int_t v = Consts.at(i).value;
             writeNBytes(&v, sizeof v);
         }
     }
 
-    std::vector<miniplc0::Instruction> beginCode = v.start();
+    const auto &beginCode = v.start();
     vm::u2 instructions_count = beginCode.size();
     writeNBytes(&instructions_count, sizeof instructions_count);
 
-    for(auto it:beginCode)
+    for(const auto &it:beginCode)
         catOp(it,out);
 
-    std::vector<miniplc0::Function> funlist = v.funcs();
+    const auto &funlist = v.funcs();
     vm::u2 functions_count = funlist.size();
     writeNBytes(&functions_count, sizeof functions_count);
 
-    std::vector<std::vector<miniplc0::Instruction>> program = v.codes();
+    const auto &program = v.codes();
     for(int i=0;i<funlist.size();i++)
     {
         vm::u2 v;
@@ -220,7 +217,7 @@ void Binary(miniplc0::Program &v, std::ofstream &out) {
         v = funlist[i].level;     writeNBytes(&v, sizeof v);
         v = program[i+1].size();     writeNBytes(&v, sizeof v);
         //ins_count 16
-        for(auto it:program[i+1])
+        for(const auto &it:program[i+1])
         {
             catOp(it,out);
         }
@@ -12,6 +12,6 @@
 #include <iostream>
 #include <fstream>
 
-inline void catOp(miniplc0::Instruction &instruction,std::ofstream &out);
+inline void catOp(const miniplc0::Instruction &instruction,std::ofstream &out);
 
-void Binary(miniplc0::Program&, std::ofstream &out);
\ No newline at end of file
+void Binary(const miniplc0::Program&, std::ofstream &out);
\ No newline at end of file
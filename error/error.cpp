@@ -0,0 +1,11 @@
+#include "error/error.h"
+#include "tokenizer/source.h"
+
+namespace miniplc0 {
+
+	std::pair<std::uint64_t, std::uint64_t> CompilationError::GetPos() const {
+		if (_pos.src == nullptr)
+			return std::make_pair(0, 0);
+		return _pos.src->Position(_pos.offset);
+	}
+}
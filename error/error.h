@@ -52,6 +52,16 @@ namespace miniplc0 {
         ErrAssignmentExpression
 	};
 
+	class SourceBuffer;
+
+	// 源码中的一个位置，只记录在缓冲区中的字节偏移
+	// 行号和列号只在输出错误时通过缓冲区的行首偏移表换算
+	struct SourcePos {
+		const SourceBuffer* src;
+		std::uint32_t offset;
+		bool operator==(const SourcePos& rhs) const { return src == rhs.src && offset == rhs.offset; }
+	};
+
 	class CompilationError final{
 	private:
 		using uint64_t = std::uint64_t;
@@ -59,17 +69,20 @@ namespace miniplc0 {
 
 		friend void swap(CompilationError& lhs, CompilationError& rhs);
 
-		CompilationError(uint64_t line, uint64_t column, ErrorCode err) :_pos(line, column), _err(err) {}
-		CompilationError(std::pair<uint64_t, uint64_t> pos, ErrorCode err) : CompilationError(pos.first, pos.second, err) {}
+		CompilationError(SourcePos pos, ErrorCode err) :_pos(pos), _err(err) {}
+		// 没有具体位置的错误，报告在 (0, 0)
+		CompilationError(ErrorCode err) : CompilationError(SourcePos{ nullptr, 0 }, err) {}
 		CompilationError(const CompilationError& ce) { _pos = ce._pos; _err = ce._err; }
-		CompilationError(CompilationError&& ce) :CompilationError(0, 0, ErrorCode::ErrNoError) { swap(*this, ce); }
+		CompilationError(CompilationError&& ce) :CompilationError(ErrorCode::ErrNoError) { swap(*this, ce); }
 		CompilationError& operator=(CompilationError ce) { swap(*this, ce); return *this; }
 		bool operator==(const CompilationError& rhs) const { return _pos == rhs._pos && _err == rhs._err; }
 
-		std::pair<uint64_t, uint64_t> GetPos()const { return _pos; }
+		std::uint32_t GetOffset() const { return _pos.offset; }
+		// <行号，列号>，需要 SourceBuffer 的完整定义，所以放在 error.cpp
+		std::pair<uint64_t, uint64_t> GetPos() const;
 		ErrorCode GetCode() const { return _err; }
 	private:
-		std::pair<uint64_t, uint64_t> _pos;
+		SourcePos _pos;
 		ErrorCode _err;
 	};
 
@@ -127,19 +127,6 @@ namespace fmt {
 }
 
 namespace fmt {
-	template<>
-	struct formatter<miniplc0::Token> {
-		template <typename ParseContext>
-		constexpr auto parse(ParseContext &ctx) { return ctx.begin(); }
-
-		template <typename FormatContext>
-		auto format(const miniplc0::Token &p, FormatContext &ctx) {
-			return format_to(ctx.out(),
-				"Line: {} Column: {} Type: {} Value: {}",
-				p.GetStartPos().first, p.GetStartPos().second, p.GetType(), p.GetValueString());
-		}
-	};
-
 	template<>
 	struct formatter<miniplc0::TokenType> {
 		template <typename ParseContext>
@@ -147,7 +134,8 @@ namespace fmt {
 
 		template <typename FormatContext>
 		auto format(const miniplc0::TokenType &p, FormatContext &ctx) {
-			std::string name;
+			// 每个 token 输出一次，不要为类型名分配字符串
+			const char *name = "";
 			switch (p) {
 			case miniplc0::NULL_TOKEN:
 				name = "NullToken";
@@ -42,7 +42,7 @@ namespace miniplc0 {
 	public:
 		friend void swap(Instruction& lhs, Instruction& rhs);
     public:
-        Instruction(Operation opr, int32_t x) : _opr(opr), _x(x) {}
+        Instruction(Operation opr, int32_t x) : _opr(opr), _x(x), _y(0) {}
         Instruction(Operation opr, int32_t x,int32_t y) : _opr(opr), _x(x),_y(y) {}
         Instruction() : Instruction(Operation::ILL, 0){}
         Instruction(const Instruction& i) { _opr = i._opr; _x = i._x;_y=i._y ;}
@@ -66,4 +66,27 @@ namespace miniplc0 {
 		swap(lhs._x, rhs._x);
         swap(lhs._y, rhs._y);
 	}
+
+	// 条件跳转和无条件跳转，x 是目标指令在函数代码中的下标
+	inline bool IsJump(Operation opr) {
+		switch (opr) {
+		case JE: case JNE: case JMP: case JG: case JL: case JGE: case JLE:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// 条件相反的条件跳转，比如 je 和 jne、jl 和 jge
+	inline Operation InvertJump(Operation opr) {
+		switch (opr) {
+		case JE: return JNE;
+		case JNE: return JE;
+		case JL: return JGE;
+		case JGE: return JL;
+		case JG: return JLE;
+		case JLE: return JG;
+		default: return ILL;
+		}
+	}
 }
\ No newline at end of file
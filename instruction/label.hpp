@@ -0,0 +1,47 @@
+#pragma once
+
+#include "instruction/instruction.h"
+#include "error/error.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace miniplc0 {
+
+	// 符号标号
+	// 生成跳转时 x 先存标号，标号的位置可以之后再确定（向前跳转时还不知道目标）
+	// 整段代码排好以后 Resolve 一次性把所有跳转的 x 换成目标指令的下标
+	class LabelTable final {
+	private:
+		using int32_t = std::int32_t;
+	public:
+		// 新建一个还没有位置的标号
+		int32_t New() {
+			_positions.push_back(-1);
+			return static_cast<int32_t>(_positions.size() - 1);
+		}
+		// 新建一个标号，放在下标为 pos 的指令前
+		int32_t New(int32_t pos) {
+			auto label = New();
+			Place(label, pos);
+			return label;
+		}
+		void Place(int32_t label, int32_t pos) { _positions[label] = pos; }
+
+		// 所有跳转的目标都必须已经放好
+		void Resolve(std::vector<Instruction>& code) const {
+			for (auto& ins : code) {
+				if (!IsJump(ins.GetOperation()))
+					continue;
+				auto label = ins.GetX();
+				if (label < 0 || static_cast<std::size_t>(label) >= _positions.size() || _positions[label] < 0)
+					DieAndPrint("jumping to an unplaced label.");
+				ins.SetX(_positions[label]);
+			}
+		}
+
+		void Clear() { _positions.clear(); }
+	private:
+		std::vector<int32_t> _positions;
+	};
+}
@@ -1,15 +1,38 @@
 #include "argparse.hpp"
 #include "fmt/core.h"
+#include "fmt/format.h"
 #include "tokenizer/tokenizer.h"
+#include "tokenizer/parallel.h"
+#include "tokenizer/token_cache.h"
 #include "analyser/analyser.h"
+#include "optimizer/optimizer.h"
 #include "fmts.hpp"
 #include "binary/binary.h"
 #include <iostream>
 #include <fstream>
+#include <thread>
 
-std::vector<miniplc0::Token> _tokenize(std::istream &input) {
-    miniplc0::Tokenizer tkz(input);
-    auto p = tkz.AllTokens();
+// 词法分析相关的命令行选项
+struct LexOptions {
+    miniplc0::LexerEngine engine;
+    // 大于 1 时分段并行词法分析，结果和顺序分析相同
+    unsigned chunks;
+    // token 缓存文件，为空时不使用缓存
+    std::string cache;
+};
+
+// 优化相关的命令行选项
+struct OptOptions {
+    // -O 的参数，0 不优化
+    int level;
+    // 向 stderr 输出每个函数删掉的指令数
+    bool report;
+    // 语法分析时做常量折叠，--no-fold 关掉
+    bool fold;
+};
+
+miniplc0::TokenStream _tokenize(const miniplc0::SourceBuffer &input, const LexOptions &lex) {
+    auto p = miniplc0::ParallelTokenize(input, lex.chunks, lex.engine);
     if (p.second.has_value()) {
         fmt::print(stderr, "Tokenization error: {}\n", p.second.value());
         exit(2);
@@ -17,48 +40,116 @@ std::vector<miniplc0::Token> _tokenize(std::istream &input) {
     return p.first;
 }
 
-void Tokenize(std::istream &input, std::ostream &output) {
-    auto v = _tokenize(input);
-    for (auto &it : v)
-        output << fmt::format("{}\n", it);
+void _append(fmt::memory_buffer &buf, std::string_view s) {
+    buf.append(s.data(), s.data() + s.size());
+}
+
+void _append(fmt::memory_buffer &buf, const fmt::format_int &i) {
+    buf.append(i.data(), i.data() + i.size());
+}
+
+// 所有 token 格式化到同一个缓冲区里，攒够一块再写出去，每一行不再生成临时字符串
+void Tokenize(const miniplc0::SourceBuffer &input, std::ostream &output, const LexOptions &lex) {
+    const std::size_t flush_size = 1 << 20;
+    auto v = _tokenize(input, lex);
+    fmt::memory_buffer buf;
+    for (std::size_t i = 0; i < v.size(); i++) {
+        // token 只记录偏移，输出时才换算行号列号
+        auto pos = v.Source().Position(v.Offset(i));
+        auto kind = v.Kind(i);
+        _append(buf, "Line: ");
+        _append(buf, fmt::format_int(pos.first));
+        _append(buf, " Column: ");
+        _append(buf, fmt::format_int(pos.second));
+        fmt::format_to(buf, " Type: {} Value: ", kind);
+        if (kind == miniplc0::UNSIGNED_INTEGER || kind == miniplc0::UNSIGNED_HEX_INTEGER)
+            _append(buf, fmt::format_int(v.Value(i)));
+        else
+            _append(buf, v.Text(i));
+        buf.push_back('\n');
+        if (buf.size() >= flush_size) {
+            output.write(buf.data(), buf.size());
+            buf.clear();
+        }
+    }
+    output.write(buf.data(), buf.size());
     return;
 }
 
-void Analyse(std::istream &input, std::ostream &output) {
-    auto tks = _tokenize(input);
+miniplc0::Program _analyseTokens(const miniplc0::TokenStream &tokens, const OptOptions &opt) {
+    miniplc0::Analyser analyser(tokens, opt.fold);
+    auto r = std::move(analyser).Analyse();
+    if (r.error.has_value()) {
+        fmt::print(stderr, "Syntactic analysis error: {}\n", r.error.value());
+        exit(2);
+    }
+    return std::move(r.program);
+}
 
-    miniplc0::Analyser analyser(tks);
-    auto p = analyser.Analyse();
-    if (p.second.has_value()) {
-        fmt::print(stderr, "Syntactic analysis error: {}\n", p.second.value());
+// 语法分析直接从词法分析器按需取 token，不再先生成整个 token 序列
+// 使用缓存或者分段并行词法分析时先得到整个 token 序列，再从 TokenStream 分析
+miniplc0::Program _analyse(const miniplc0::SourceBuffer &input, const LexOptions &lex, const OptOptions &opt) {
+    if (!lex.cache.empty()) {
+        auto cached = miniplc0::LoadTokenCache(lex.cache, input);
+        if (cached.has_value())
+            return _analyseTokens(cached.value(), opt);
+        // 缓存是修改之前写的，只重新分析改动附近的 token
+        auto relexed = miniplc0::RelexTokenCache(lex.cache, input, lex.engine);
+        auto tokens = relexed.has_value() ? std::move(relexed.value()) : _tokenize(input, lex);
+        if (!miniplc0::SaveTokenCache(lex.cache, tokens))
+            fmt::print(stderr, "Fail to write token cache {}.\n", lex.cache);
+        return _analyseTokens(tokens, opt);
+    }
+    if (lex.chunks > 1)
+        return _analyseTokens(_tokenize(input, lex), opt);
+    miniplc0::Tokenizer tkz(input, lex.engine);
+    miniplc0::Analyser analyser(tkz, opt.fold);
+    auto r = std::move(analyser).Analyse();
+    if (r.error.has_value()) {
+        fmt::print(stderr, "{}: {}\n", r.lexical ? "Tokenization error" : "Syntactic analysis error", r.error.value());
         exit(2);
     }
-    auto v = p.first;
-    std::vector<std::pair<std::string, int>> cons = v.cons();
+    return std::move(r.program);
+}
+
+miniplc0::Program _compile(const miniplc0::SourceBuffer &input, const LexOptions &lex, const OptOptions &opt) {
+    auto v = _analyse(input, lex, opt);
+    auto report = miniplc0::Optimize(v, opt.level);
+    if (opt.report) {
+        for (const auto &f : report.functions)
+            fmt::print(stderr, "{}: {} -> {} instructions, {} removed\n", f.name, f.before, f.after, f.before - f.after);
+        fmt::print(stderr, ".constants: {} removed\n", report.constants_removed);
+    }
+    return v;
+}
+
+void Analyse(const miniplc0::SourceBuffer &input, std::ostream &output, const LexOptions &lex, const OptOptions &opt) {
+    auto v = _compile(input, lex, opt);
+    const auto &cons = v.cons();
     output << fmt::format(".constants:\n");
     for (int i = 0; i < cons.size(); i++) {
-        std::string type, value = cons[i].first;
-        if (cons[i].second == 0) type = "I";
-        else{ type = "S"; value = '"'+value+'"';}
-        output << fmt::format("\t{} {} {}\n", i, type, value);
+        if (cons[i].type == 0)
+            output << fmt::format("\t{} I {}\n", i, cons[i].value);
+        else
+            output << fmt::format("\t{} S \"{}\"\n", i, cons[i].str);
     }
     // 全局量加载
-    std::vector<miniplc0::Instruction> start = v.start();
+    const auto &start = v.start();
     output << fmt::format("\n.start:\n");
     for (int i = 0; i < start.size(); i++) {
         output << fmt::format("\t{} {}\n", i, start[i]);
     }
     // 函数表
-    std::vector<miniplc0::Function> funlist = v.funcs();
+    const auto &funlist = v.funcs();
     output << fmt::format("\n.functions:\n");
     for (int i = 0; i < funlist.size(); i++) {
         output << fmt::format("\t{} {} {} {}\n", i, funlist[i].nameindex, funlist[i].getParaSize(), funlist[i].level);
     }
     // 函数代码
-    std::vector<std::vector<miniplc0::Instruction>> program = v.codes();
+    const auto &program = v.codes();
     output << fmt::format("\n");
     for (int i = 1; i < program.size(); i++) {
-        auto  p = program[i];
+        const auto &p = program[i];
         output << fmt::format(".F{}:\n", i - 1);
         for (int j = 0; j < p.size(); j++) {
             output << fmt::format("\t{} {}\n", j, p[j]);
@@ -88,9 +179,37 @@ int main(int argc, char **argv) {
             .required()
             .default_value(std::string("-"))
             .help("specify the output file.");
+    program.add_argument("--lexer")
+            .default_value(std::string("switch"))
+            .help("choose the lexer implementation: switch or table.");
+    program.add_argument("--lex-chunks")
+            .default_value(std::string("1"))
+            .help("split the input into this many chunks (at most 4096) and tokenize them in parallel, 0 for one per hardware thread.");
+    program.add_argument("--token-cache")
+            .default_value(false)
+            .implicit_value(true)
+            .help("reuse the tokens in <input>.tokens when the input is unchanged, re-tokenize only the edited part when it has changed, and write the new tokens there (-s and -c only).");
+    program.add_argument("-O")
+            .default_value(std::string("0"))
+            .help("optimization level. 0 does not optimize the generated code (default); 1 removes unreachable code and unused constants, rotates loops, threads jumps and rewrites wasteful instruction patterns.");
+    program.add_argument("--no-fold")
+            .default_value(false)
+            .implicit_value(true)
+            .help("do not evaluate constant expressions at compile time.");
+    program.add_argument("--opt-report")
+            .default_value(false)
+            .implicit_value(true)
+            .help("print how many instructions the optimizer removed from every function to stderr.");
 
+    // argparse 不认识 -O1 这种连写的参数，拆成 -O 1
+    std::vector<std::string> args(argv, argv + argc);
+    for (std::size_t i = 1; i < args.size(); i++)
+        if (args[i].size() > 2 && args[i].compare(0, 2, "-O") == 0) {
+            args.insert(args.begin() + i + 1, args[i].substr(2));
+            args[i].resize(2);
+        }
     try {
-        program.parse_args(argc, argv);
+        program.parse_args(args);
     }
     catch (const std::runtime_error &err) {
         fmt::print(stderr, "{}\n\n", err.what());
@@ -100,19 +219,57 @@ int main(int argc, char **argv) {
 
     auto input_file = program.get<std::string>("input");
     auto output_file = program.get<std::string>("--output");
-    std::istream *input;
+    auto lexer = program.get<std::string>("--lexer");
+    LexOptions lex;
+    if (lexer == "switch")
+        lex.engine = miniplc0::SWITCH_LEXER;
+    else if (lexer == "table")
+        lex.engine = miniplc0::TABLE_LEXER;
+    else {
+        fmt::print(stderr, "Unknown lexer {}, expect switch or table.\n", lexer);
+        exit(2);
+    }
+    // stoul 会接受前导空白和负号（-1 变成 ULONG_MAX），所以先检查只有数字
+    auto chunks = program.get<std::string>("--lex-chunks");
+    try {
+        if (chunks.empty() || chunks.find_first_not_of("0123456789") != std::string::npos)
+            throw std::invalid_argument("not a non-negative integer");
+        auto n = std::stoul(chunks);
+        if (n > 4096)
+            throw std::out_of_range("too many chunks");
+        lex.chunks = n == 0 ? std::max(1u, std::thread::hardware_concurrency()) : static_cast<unsigned>(n);
+    }
+    catch (const std::logic_error &) {
+        fmt::print(stderr, "Invalid chunk count {}, expect an integer from 0 to 4096.\n", chunks);
+        exit(2);
+    }
+    OptOptions opt;
+    auto level = program.get<std::string>("-O");
+    if (level == "0" || level == "1")
+        opt.level = level[0] - '0';
+    else {
+        fmt::print(stderr, "Unknown optimization level {}, expect 0 or 1.\n", level);
+        exit(2);
+    }
+    opt.report = program["--opt-report"] == true;
+    opt.fold = program["--no-fold"] == false;
+    miniplc0::SourceBuffer source;
     std::ostream *output;
-    std::ifstream inf;
     std::ofstream outf;
     if (input_file != "-") {
-        inf.open(input_file, std::ios::in);
-        if (!inf) {
+        // 文件输入直接映射到内存，不再逐行拷贝
+        auto src = miniplc0::SourceBuffer::FromFile(input_file);
+        if (!src.has_value()) {
             fmt::print(stderr, "Fail to open {} for reading.\n", input_file);
             exit(2);
         }
-        input = &inf;
+        source = std::move(src.value());
     } else
-        input = &std::cin;
+        source = miniplc0::SourceBuffer::FromStream(std::cin);
+    const miniplc0::SourceBuffer *input = &source;
+    // 标准输入没有可以放缓存的位置
+    if (program["--token-cache"] == true && input_file != "-")
+        lex.cache = input_file + ".tokens";
     if (program["-t"] == true && program["-s"] == true) {
         fmt::print(stderr, "You can only perform tokenization or syntactic analysis at one time.");
         exit(2);
@@ -127,7 +284,7 @@ int main(int argc, char **argv) {
             output = &outf;
         } else
             output = &std::cout;
-        Tokenize(*input, *output);
+        Tokenize(*input, *output, lex);
     } else if (program["-s"] == true) {
         if (output_file != "-") {
             outf.open(output_file, std::ios::out | std::ios::trunc);
@@ -145,7 +302,7 @@ int main(int argc, char **argv) {
             }
         }
         output = &outf;
-        Analyse(*input, *output);
+        Analyse(*input, *output, lex, opt);
     } else if (program["-c"] == true) {
         if (output_file != "-") {
             outf.open(output_file, std::ios::binary | std::ios::out | std::ios::trunc);
@@ -164,14 +321,7 @@ int main(int argc, char **argv) {
             output = &outf;
         }
         std::ofstream* real_out = dynamic_cast<std::ofstream*>(output);
-        auto tks = _tokenize(*input);
-        miniplc0::Analyser analyser(tks);
-        auto p = analyser.Analyse();
-        if (p.second.has_value()) {
-            fmt::print(stderr, "Syntactic analysis error: {}\n", p.second.value());
-            exit(2);
-        }
-        miniplc0::Program v = p.first;
+        miniplc0::Program v = _compile(*input, lex, opt);
         Binary(v, *real_out);
     } else {
         fmt::print(stderr, "You must choose tokenization or syntactic analysis.");
@@ -0,0 +1,125 @@
+#include "optimizer/cfg.h"
+#include "instruction/label.hpp"
+#include "error/error.h"
+
+#include <algorithm>
+
+namespace miniplc0 {
+
+    namespace {
+        // 执行完这条指令后不会顺序执行下一条
+        bool isTerminator(Operation opr) {
+            return opr == JMP || opr == RET || opr == IRET;
+        }
+    }
+
+    ControlFlowGraph::ControlFlowGraph(const std::vector<Instruction>& code) {
+        auto n = code.size();
+        if (n == 0)
+            return;
+        // 块的开头：入口、跳转目标、跳转和返回之后的指令
+        // 跳到 n 表示跳出代码的末尾，为它留一个空块
+        std::vector<bool> leader(n + 1, false);
+        leader[0] = true;
+        for (std::size_t i = 0; i < n; i++) {
+            auto opr = code[i].GetOperation();
+            if (IsJump(opr)) {
+                auto x = code[i].GetX();
+                if (x < 0 || static_cast<std::size_t>(x) > n)
+                    DieAndPrint("jump target out of the function.");
+                leader[x] = true;
+            }
+            if (IsJump(opr) || opr == RET || opr == IRET)
+                leader[i + 1] = true;
+        }
+        bool exit = false;
+        for (auto& ins : code)
+            if (IsJump(ins.GetOperation()) && static_cast<std::size_t>(ins.GetX()) == n)
+                exit = true;
+
+        // 每条指令所在块的编号
+        std::vector<std::size_t> block(n + 1);
+        for (std::size_t i = 0; i < n; i++) {
+            if (leader[i])
+                _blocks.emplace_back();
+            block[i] = _blocks.size() - 1;
+            _blocks.back().code.push_back(code[i]);
+        }
+        if (exit)
+            _blocks.emplace_back();
+        block[n] = _blocks.size() - 1;
+
+        for (std::size_t b = 0; b < _blocks.size(); b++) {
+            auto& bb = _blocks[b];
+            if (bb.code.empty())
+                continue;
+            auto& last = bb.code.back();
+            if (IsJump(last.GetOperation()))
+                last.SetX(static_cast<int32_t>(block[last.GetX()]));
+            if (!isTerminator(last.GetOperation()) && b + 1 < _blocks.size())
+                bb.fallthrough = b + 1;
+        }
+        Link();
+    }
+
+    void ControlFlowGraph::Link() {
+        for (auto& bb : _blocks) {
+            bb.succs.clear();
+            bb.preds.clear();
+        }
+        for (std::size_t b = 0; b < _blocks.size(); b++) {
+            auto& bb = _blocks[b];
+            if (!bb.code.empty() && IsJump(bb.code.back().GetOperation()))
+                bb.succs.push_back(static_cast<std::size_t>(bb.code.back().GetX()));
+            if (bb.fallthrough.has_value() && std::find(bb.succs.begin(), bb.succs.end(), bb.fallthrough.value()) == bb.succs.end())
+                bb.succs.push_back(bb.fallthrough.value());
+            for (auto s : bb.succs)
+                _blocks[s].preds.push_back(b);
+        }
+    }
+
+    std::vector<bool> ControlFlowGraph::Reachable() const {
+        std::vector<bool> seen(_blocks.size(), false);
+        if (_blocks.empty())
+            return seen;
+        std::vector<std::size_t> stack{ 0 };
+        seen[0] = true;
+        while (!stack.empty()) {
+            auto b = stack.back();
+            stack.pop_back();
+            for (auto s : _blocks[b].succs)
+                if (!seen[s]) {
+                    seen[s] = true;
+                    stack.push_back(s);
+                }
+        }
+        return seen;
+    }
+
+    std::vector<Instruction> ControlFlowGraph::Layout(const std::vector<std::size_t>& order) const {
+        // 标号就是块的编号
+        LabelTable labels;
+        for (std::size_t b = 0; b < _blocks.size(); b++)
+            labels.New();
+        std::vector<Instruction> code;
+        // 执行从第一条指令开始，入口块不排在最前面时先跳到入口
+        if (!order.empty() && order[0] != 0)
+            code.emplace_back(JMP, 0);
+        for (std::size_t i = 0; i < order.size(); i++) {
+            auto& bb = _blocks[order[i]];
+            labels.Place(static_cast<int32_t>(order[i]), static_cast<int32_t>(code.size()));
+            code.insert(code.end(), bb.code.begin(), bb.code.end());
+            if (bb.fallthrough.has_value() && (i + 1 == order.size() || order[i + 1] != bb.fallthrough.value()))
+                code.emplace_back(JMP, static_cast<int32_t>(bb.fallthrough.value()));
+        }
+        labels.Resolve(code);
+        return code;
+    }
+
+    std::vector<Instruction> ControlFlowGraph::Layout() const {
+        std::vector<std::size_t> order(_blocks.size());
+        for (std::size_t b = 0; b < order.size(); b++)
+            order[b] = b;
+        return Layout(order);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "instruction/instruction.h"
+
+#include <optional>
+#include <vector>
+#include <cstddef>
+
+namespace miniplc0 {
+
+    // 基本块：只能从第一条指令进入，只有最后一条指令可能是跳转、ret 或者 iret
+    struct BasicBlock {
+        // 最后一条是跳转时，它的 x 是目标块的编号，不是指令下标
+        std::vector<Instruction> code;
+        // 执行完最后一条指令后顺序进入的块，最后一条是 jmp、ret、iret 时为空
+        std::optional<std::size_t> fallthrough;
+        // 由 Link 计算，后继中跳转目标在前、fallthrough 在后，都不重复
+        std::vector<std::size_t> succs;
+        std::vector<std::size_t> preds;
+    };
+
+    // 一个函数的控制流图
+    // 构造时把代码切成基本块，跳转目标从指令下标换成块的编号，之后可以随意增删块内的指令
+    // Layout 时才重新排列并确定每个跳转的目标下标
+    class ControlFlowGraph final {
+        public:
+            explicit ControlFlowGraph(const std::vector<Instruction>& code);
+
+            // 0 号块是入口
+            std::size_t size() const { return _blocks.size(); }
+            BasicBlock& operator[](std::size_t i) { return _blocks[i]; }
+            const BasicBlock& operator[](std::size_t i) const { return _blocks[i]; }
+
+            // 改写了跳转或者 fallthrough 之后重新计算前驱和后继
+            void Link();
+            // 从入口出发能到达的块
+            std::vector<bool> Reachable() const;
+
+            // 按 order 排列块生成代码，块的 fallthrough 不紧跟在它后面时补一条 jmp
+            // 入口块不在最前面时，开头补一条跳到入口的 jmp
+            // 不在 order 里的块被丢掉，它们不能是留下的块的后继
+            std::vector<Instruction> Layout(const std::vector<std::size_t>& order) const;
+            // 按块的编号顺序排列
+            std::vector<Instruction> Layout() const;
+        private:
+            std::vector<BasicBlock> _blocks;
+    };
+}
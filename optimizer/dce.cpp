@@ -0,0 +1,54 @@
+#include "optimizer/dce.h"
+#include "optimizer/cfg.h"
+
+namespace miniplc0 {
+
+    std::size_t RemoveUnreachable(std::vector<Instruction>& code) {
+        ControlFlowGraph cfg(code);
+        auto reachable = cfg.Reachable();
+        std::vector<std::size_t> order;
+        for (std::size_t b = 0; b < cfg.size(); b++)
+            if (reachable[b])
+                order.push_back(b);
+        if (order.size() == cfg.size())
+            return 0;
+        // 可达块的 fallthrough 也是可达的，而且就是下一块，Layout 不会补 jmp
+        auto before = code.size();
+        code = cfg.Layout(order);
+        return before - code.size();
+    }
+
+    std::size_t RemoveUnusedConstants(std::vector<Constant>& consts, std::vector<Function>& funcs,
+                                      std::vector<std::vector<Instruction>>& codes) {
+        std::vector<bool> used(consts.size(), false);
+        for (auto& f : funcs)
+            used[f.nameindex] = true;
+        for (auto& code : codes)
+            for (auto& ins : code)
+                if (ins.GetOperation() == LOADC)
+                    used[ins.GetX()] = true;
+
+        // 旧编号到新编号
+        std::vector<int32_t> remap(consts.size());
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < consts.size(); i++) {
+            remap[i] = static_cast<int32_t>(kept);
+            if (used[i]) {
+                if (kept != i)
+                    consts[kept] = std::move(consts[i]);
+                kept++;
+            }
+        }
+        auto removed = consts.size() - kept;
+        if (removed == 0)
+            return 0;
+        consts.resize(kept);
+        for (auto& f : funcs)
+            f.nameindex = remap[f.nameindex];
+        for (auto& code : codes)
+            for (auto& ins : code)
+                if (ins.GetOperation() == LOADC)
+                    ins.SetX(remap[ins.GetX()]);
+        return removed;
+    }
+}
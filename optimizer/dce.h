@@ -0,0 +1,19 @@
+#pragma once
+
+#include "instruction/instruction.h"
+#include "analyser/analyser.h"
+
+#include <vector>
+#include <cstddef>
+
+namespace miniplc0 {
+
+    // 删掉从入口到达不了的基本块（return 之后的语句、函数末尾多余的 popn/ret 等）
+    // 留下的块保持原来的顺序，返回删掉的指令数
+    std::size_t RemoveUnreachable(std::vector<Instruction>& code);
+
+    // 删掉没有被 loadc 和函数名引用的常量，留下的常量保持原来的顺序并重新编号
+    // 返回删掉的常量数
+    std::size_t RemoveUnusedConstants(std::vector<Constant>& consts, std::vector<Function>& funcs,
+                                      std::vector<std::vector<Instruction>>& codes);
+}
@@ -0,0 +1,93 @@
+#include "optimizer/jump.h"
+#include "optimizer/cfg.h"
+
+namespace miniplc0 {
+
+    namespace {
+        bool isJmpOnly(const BasicBlock& bb) {
+            return bb.code.size() == 1 && bb.code[0].GetOperation() == JMP;
+        }
+
+        // 从 b 出发沿着只有一条 jmp 的块走到底
+        // 最多走 cfg.size() 步，while (1) {} 这样的死循环里 jmp 会绕回来
+        std::size_t forward(const ControlFlowGraph& cfg, std::size_t b) {
+            for (std::size_t k = 0; k < cfg.size() && isJmpOnly(cfg[b]); k++) {
+                auto t = static_cast<std::size_t>(cfg[b].code[0].GetX());
+                if (t == b)
+                    break;
+                b = t;
+            }
+            return b;
+        }
+
+        // jcc X; F: jmp T; X: 改写成 jcc' T; X:，F 只能从这个块进入
+        bool invert(ControlFlowGraph& cfg, std::size_t b) {
+            auto& bb = cfg[b];
+            if (bb.code.empty() || !bb.fallthrough.has_value())
+                return false;
+            auto& last = bb.code.back();
+            auto opr = last.GetOperation();
+            if (!IsJump(opr) || opr == JMP)
+                return false;
+            auto f = bb.fallthrough.value();
+            auto x = static_cast<std::size_t>(last.GetX());
+            if (x != f + 1 || !isJmpOnly(cfg[f]) || cfg[f].preds.size() != 1)
+                return false;
+            auto t = cfg[f].code[0].GetX();
+            if (static_cast<std::size_t>(t) == f)
+                return false;
+            last = Instruction(InvertJump(opr), t);
+            bb.fallthrough = x;
+            return true;
+        }
+    }
+
+    std::size_t ThreadJumps(std::vector<Instruction>& code) {
+        ControlFlowGraph cfg(code);
+        if (cfg.size() == 0)
+            return 0;
+
+        for (std::size_t b = 0; b < cfg.size(); b++) {
+            auto& bb = cfg[b];
+            if (!bb.code.empty() && IsJump(bb.code.back().GetOperation()))
+                bb.code.back().SetX(static_cast<int32_t>(forward(cfg, static_cast<std::size_t>(bb.code.back().GetX()))));
+        }
+        cfg.Link();
+
+        // 翻转以后新的 fallthrough 可能又是一个只有 jmp 的块
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (std::size_t b = 0; b < cfg.size(); b++)
+                if (invert(cfg, b)) {
+                    cfg.Link();
+                    changed = true;
+                }
+        }
+
+        // 留下的块保持原来的顺序，被跳过的 jmp 块没有别的前驱，已经到达不了
+        auto reachable = cfg.Reachable();
+        std::vector<std::size_t> order;
+        for (std::size_t b = 0; b < cfg.size(); b++)
+            if (reachable[b])
+                order.push_back(b);
+        for (std::size_t i = 0; i < order.size(); i++) {
+            auto& bb = cfg[order[i]];
+            if (bb.code.empty())
+                continue;
+            auto& last = bb.code.back();
+            auto opr = last.GetOperation();
+            auto x = static_cast<std::size_t>(last.GetX());
+            if (opr == JMP && i + 1 < order.size() && x == order[i + 1]) {
+                bb.code.pop_back();
+                bb.fallthrough = x;
+            } else if (IsJump(opr) && opr != JMP && bb.fallthrough == x) {
+                // 无论跳不跳都到同一个块，只需要弹出比较结果
+                last = Instruction(POP, 0);
+            }
+        }
+
+        auto before = code.size();
+        code = cfg.Layout(order);
+        return before - code.size();
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "instruction/instruction.h"
+
+#include <vector>
+#include <cstddef>
+
+namespace miniplc0 {
+
+    // 跳转串联优化，在一个函数的控制流图上：
+    // 1.跳到只有一条 jmp 的块时直接跳到那条 jmp 的目标
+    // 2.jcc L; jmp T; L: 改写成 jcc' T; L:，jcc' 是条件相反的跳转
+    // 3.删掉跳到下一条指令的 jmp，条件跳转的两个去向相同时换成 pop
+    // 改写后到达不了的块被删掉，返回删掉的指令数
+    std::size_t ThreadJumps(std::vector<Instruction>& code);
+}
@@ -0,0 +1,52 @@
+#include "optimizer/loop.h"
+#include "optimizer/cfg.h"
+
+namespace miniplc0 {
+
+    std::size_t RotateLoops(std::vector<Instruction>& code) {
+        ControlFlowGraph cfg(code);
+        auto n = cfg.size();
+        // 条件块 h 以 jcc x 结尾并且顺序进入循环体 h + 1，循环体最后一块 x - 1 以 jmp h 结尾
+        // 块的编号就是原来的顺序，内层循环整个在外层的循环体里，各自旋转互不影响
+        std::vector<std::size_t> rotated(n, n);
+        std::size_t count = 0;
+        for (std::size_t h = 0; h < n; h++) {
+            auto& bb = cfg[h];
+            if (bb.code.empty() || !bb.fallthrough.has_value())
+                continue;
+            auto opr = bb.code.back().GetOperation();
+            if (!IsJump(opr) || opr == JMP)
+                continue;
+            auto x = static_cast<std::size_t>(bb.code.back().GetX());
+            if (x <= h + 1)
+                continue;
+            auto& latch = cfg[x - 1];
+            if (latch.code.empty() || latch.code.back().GetOperation() != JMP || static_cast<std::size_t>(latch.code.back().GetX()) != h)
+                continue;
+            // 循环体最后一块顺序进入挪过来的条件块，条件块不满足时顺序出循环
+            latch.code.pop_back();
+            latch.fallthrough = h;
+            bb.code.back() = Instruction(InvertJump(opr), static_cast<int32_t>(h + 1));
+            bb.fallthrough = x;
+            rotated[x - 1] = h;
+            count++;
+        }
+        if (count == 0)
+            return 0;
+
+        // 进入循环的块原来顺序进入条件块，Layout 会给它补一条 jmp，条件块是入口时也一样
+        std::vector<std::size_t> order;
+        std::vector<bool> moved(n, false);
+        for (std::size_t b = 0; b < n; b++)
+            if (rotated[b] != n)
+                moved[rotated[b]] = true;
+        for (std::size_t b = 0; b < n; b++) {
+            if (!moved[b])
+                order.push_back(b);
+            if (rotated[b] != n)
+                order.push_back(rotated[b]);
+        }
+        code = cfg.Layout(order);
+        return count;
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "instruction/instruction.h"
+
+#include <vector>
+#include <cstddef>
+
+namespace miniplc0 {
+
+    // 循环旋转
+    // while 循环生成的代码是 cond; jcc exit; body; jmp cond; exit:，每次迭代执行两次跳转
+    // 把条件块挪到循环体后面：jmp cond; body; cond; jcc' body; exit:，jcc' 是条件相反的跳转
+    // 每次迭代只执行一次条件跳转，进入循环时多执行一条 jmp
+    // 返回旋转的循环数
+    std::size_t RotateLoops(std::vector<Instruction>& code);
+}
@@ -0,0 +1,29 @@
+#include "optimizer/optimizer.h"
+#include "optimizer/peephole.h"
+#include "optimizer/dce.h"
+#include "optimizer/jump.h"
+#include "optimizer/loop.h"
+
+namespace miniplc0 {
+
+    OptimizeReport Optimize(Program& program, int level) {
+        OptimizeReport report;
+        if (level <= 0)
+            return report;
+        // _program[0] 是 .start，_program[i] 是第 i - 1 个函数
+        for (std::size_t i = 0; i < program._program.size(); i++) {
+            auto& code = program._program[i];
+            auto name = i == 0 ? std::string(".start") : program._CONSTS[program._funcs[i - 1].nameindex].str;
+            auto before = code.size();
+            RemoveUnreachable(code);
+            // 窥孔优化删掉作用域末尾的 popn 0 以后，才能看出哪些块只剩一条 jmp
+            Peephole(code, program._CONSTS);
+            // 先旋转循环，跳转串联会把内层循环的出口直接接到外层的条件块上，之后就认不出外层循环了
+            RotateLoops(code);
+            ThreadJumps(code);
+            report.functions.push_back(FunctionReport{ std::move(name), before, code.size() });
+        }
+        report.constants_removed = RemoveUnusedConstants(program._CONSTS, program._funcs, program._program);
+        return report;
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "analyser/analyser.h"
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace miniplc0 {
+
+    // 一段代码（.start 或者一个函数）优化前后的指令数
+    struct FunctionReport {
+        std::string name;
+        std::size_t before;
+        std::size_t after;
+    };
+
+    struct OptimizeReport {
+        std::vector<FunctionReport> functions;
+        // 常量表中删掉的常量数
+        std::size_t constants_removed = 0;
+    };
+
+    // 在生成的代码上做优化，level 为 0 时什么都不做
+    // level 为 1（-O 1）：每个函数删掉不可达的代码，做窥孔优化、循环旋转和跳转串联，最后删掉不再使用的常量
+    OptimizeReport Optimize(Program& program, int level);
+}
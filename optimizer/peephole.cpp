@@ -0,0 +1,68 @@
+#include "optimizer/peephole.h"
+#include "analyser/fold.hpp"
+#include "error/error.h"
+
+namespace miniplc0 {
+
+    namespace {
+        // 做一遍改写，返回是否有变化
+        bool rewrite(std::vector<Instruction>& code, const std::vector<Constant>& consts) {
+            auto n = code.size();
+            std::vector<bool> target(n + 1, false);
+            for (auto& ins : code)
+                if (IsJump(ins.GetOperation())) {
+                    if (ins.GetX() < 0 || static_cast<std::size_t>(ins.GetX()) > n)
+                        DieAndPrint("jump target out of the function.");
+                    target[ins.GetX()] = true;
+                }
+
+            std::vector<Instruction> out;
+            out.reserve(n);
+            // 原来的下标到新下标，被删掉的指令对应到它后面第一条留下的指令
+            std::vector<int32_t> remap(n + 1);
+            bool changed = false;
+            for (std::size_t i = 0; i < n; i++) {
+                remap[i] = static_cast<int32_t>(out.size());
+                auto opr = code[i].GetOperation();
+                auto x = code[i].GetX();
+                // 后一条指令可以和这一条合并
+                bool pair = i + 1 < n && !target[i + 1];
+                auto next = pair ? code[i + 1].GetOperation() : ILL;
+
+                if ((opr == POPN && x == 0) || (opr == JMP && static_cast<std::size_t>(x) == i + 1)) {
+                    changed = true;
+                    continue;
+                }
+                if (next == INEG && (opr == IPUSH || (opr == LOADC && consts[x].type == 0))) {
+                    auto v = opr == IPUSH ? x : consts[x].value;
+                    out.emplace_back(IPUSH, fold::Neg(v));
+                } else if (opr == INEG && next == INEG) {
+                    // 两次取负抵消
+                } else if (opr == POPN && next == POPN) {
+                    out.emplace_back(POPN, x + code[i + 1].GetX());
+                } else {
+                    out.push_back(code[i]);
+                    continue;
+                }
+                changed = true;
+                remap[++i] = static_cast<int32_t>(out.size());
+            }
+            remap[n] = static_cast<int32_t>(out.size());
+            if (!changed)
+                return false;
+
+            for (auto& ins : out)
+                if (IsJump(ins.GetOperation()))
+                    ins.SetX(remap[ins.GetX()]);
+            code.swap(out);
+            return true;
+        }
+    }
+
+    std::size_t Peephole(std::vector<Instruction>& code, const std::vector<Constant>& consts) {
+        auto before = code.size();
+        while (rewrite(code, consts))
+            ;
+        return before - code.size();
+    }
+}
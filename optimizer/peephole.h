@@ -0,0 +1,17 @@
+#pragma once
+
+#include "instruction/instruction.h"
+#include "analyser/constant_pool.h"
+
+#include <vector>
+#include <cstddef>
+
+namespace miniplc0 {
+
+    // 窥孔优化，在一个函数的代码上反复改写到不再变化
+    // 1.loadc k; ineg 和 ipush v; ineg 合并成 ipush -v，ineg; ineg 删掉
+    // 2.删掉 popn 0 和跳到下一条指令的 jmp，相邻的 popn 合并
+    // 多条指令的模式只在后面的指令不是跳转目标时才改写，删除指令后重新计算所有跳转的目标
+    // 返回删掉的指令数
+    std::size_t Peephole(std::vector<Instruction>& code, const std::vector<Constant>& consts);
+}
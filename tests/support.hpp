@@ -0,0 +1,39 @@
+#pragma once
+
+#include "tokenizer/source.h"
+#include "tokenizer/token_stream.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// 测试共用的小工具，C0_SOURCE_DIR 由 CMakeLists.txt 定义为仓库根目录
+namespace test {
+
+    inline miniplc0::SourceBuffer Source(const std::string& text) {
+        std::istringstream is(text);
+        return miniplc0::SourceBuffer::FromStream(is);
+    }
+
+    // dir 下扩展名为 ext 的所有文件，按文件名排序，dir 相对仓库根目录
+    inline std::vector<std::string> Files(const std::string& dir, const std::string& ext) {
+        std::vector<std::string> files;
+        for (auto& e : std::filesystem::directory_iterator(std::string(C0_SOURCE_DIR) + "/" + dir))
+            if (e.is_regular_file() && e.path().extension() == ext)
+                files.push_back(e.path().string());
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    // 两个 token 序列的每一列都相同
+    inline bool SameTokens(const miniplc0::TokenStream& a, const miniplc0::TokenStream& b) {
+        if (a.size() != b.size())
+            return false;
+        for (std::size_t i = 0; i < a.size(); i++)
+            if (a.Kind(i) != b.Kind(i) || a.Offset(i) != b.Offset(i) || a.Length(i) != b.Length(i) || a.Value(i) != b.Value(i))
+                return false;
+        return true;
+    }
+}
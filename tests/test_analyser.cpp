@@ -0,0 +1,110 @@
+#include "catch2/catch.hpp"
+#include "tests/support.hpp"
+#include "analyser/analyser.h"
+#include "tokenizer/tokenizer.h"
+
+#include <string>
+#include <vector>
+
+using namespace miniplc0;
+
+namespace {
+    // 先词法分析再语法分析，和一边词法分析一边语法分析，都必须正常返回错误
+    void checkRejected(const std::string& text) {
+        INFO(text);
+        auto src = test::Source(text);
+        auto tokens = Tokenizer(src).AllTokenStream();
+        std::optional<CompilationError> err;
+        {
+            Analyser analyser(tokens.first);
+            REQUIRE_NOTHROW(err = analyser.Analyse().error);
+            CHECK(err.has_value());
+        }
+        {
+            Tokenizer tkz(src);
+            Analyser analyser(tkz);
+            REQUIRE_NOTHROW(err = analyser.Analyse().error);
+            CHECK(err.has_value());
+        }
+    }
+}
+
+TEST_CASE("truncated input is a compilation error", "[analyser]") {
+    std::vector<std::string> cases = {
+        "int",
+        "int a",
+        "int a =",
+        "int a = 1",
+        "const",
+        "const int",
+        "const int a",
+        "int main(",
+        "int main(const",
+        "int main(int",
+        "int main(int a,",
+        "int main()",
+        "int main(){",
+        "int main(){ int",
+        "int main(){ int a = 1",
+        "int f(int a){ return a; } int main(){ f(1",
+        "int f(int a){ return a; } int main(){ f(1,",
+        "int f(int a){ return a; } int main(){ f(1)",
+        "int main(){ int a; a",
+        "int main(){ int a; a =",
+        "int main(){ int a; a = a",
+        "int main(){ int a; a = a +",
+        "int main(){ int a; a = (a",
+        "int main(){ if",
+        "int main(){ if (1",
+        "int main(){ if (1 <",
+        "int main(){ if (1) {}",
+        "int main(){ if (1) {} else",
+        "int main(){ while (1) ;",
+        "int main(){ print(",
+        "int main(){ print(1,",
+        "int main(){ print(1, 2",
+        "int main(){ scan(",
+        "int main(){ return",
+        "int main(){ return 0",
+        // 词法错误让 token 流提前结束
+        "int main(){ f(1 @",
+        "int main(){ int a = 99999999999;",
+    };
+    for (auto& text : cases)
+        checkRejected(text);
+}
+
+// 把 examples/ 里的程序在每个 token 的结尾截断，都不应该崩溃
+TEST_CASE("every token prefix of examples/ is handled", "[analyser]") {
+    for (auto& path : test::Files("examples", ".c0")) {
+        auto src = SourceBuffer::FromFile(path);
+        REQUIRE(src.has_value());
+        auto tokens = Tokenizer(src.value()).AllTokenStream().first;
+        for (std::size_t i = 0; i < tokens.size(); i++) {
+            INFO(path << " cut after token " << i);
+            auto text = std::string(src.value().begin(), src.value().begin() + tokens.EndOffset(i));
+            auto prefix = test::Source(text);
+            auto ts = Tokenizer(prefix).AllTokenStream();
+            Analyser analyser(ts.first);
+            REQUIRE_NOTHROW(analyser.Analyse());
+            Tokenizer tkz(prefix);
+            Analyser streaming(tkz);
+            REQUIRE_NOTHROW(streaming.Analyse());
+        }
+    }
+}
+
+// 流式分析的词法错误随结果一起返回，右值调用之后不用再读 Analyser
+TEST_CASE("streaming Analyse reports whether the error is lexical", "[analyser]") {
+    auto bad = test::Source("int main() { int a = 1 @ 2; }");
+    Tokenizer lex(bad);
+    auto r = Analyser(lex).Analyse();
+    CHECK(r.error.has_value());
+    CHECK(r.lexical);
+
+    auto syntax = test::Source("int main() { int a = ; }");
+    Tokenizer tkz(syntax);
+    r = Analyser(tkz).Analyse();
+    CHECK(r.error.has_value());
+    CHECK_FALSE(r.lexical);
+}
@@ -0,0 +1,106 @@
+#include "catch2/catch.hpp"
+#include "tests/support.hpp"
+#include "tests/vm.hpp"
+#include "analyser/analyser.h"
+#include "tokenizer/tokenizer.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace miniplc0;
+
+namespace {
+    Program compile(const SourceBuffer& src, bool fold) {
+        Tokenizer tkz(src);
+        auto r = Analyser(tkz, fold).Analyse();
+        REQUIRE_FALSE(r.error.has_value());
+        return std::move(r.program);
+    }
+
+    // main 里只有 int x = 5; print(expr); 时，expr 生成的指令
+    std::vector<Instruction> exprCode(const std::string& expr, bool fold) {
+        auto src = test::Source("int main() { int x = 5; print(" + expr + "); return 0; }");
+        auto p = compile(src, fold);
+        auto& code = p.codes()[1];
+        auto end = std::find_if(code.begin(), code.end(), [](const Instruction& i) { return i.GetOperation() == IPRINT; });
+        return std::vector<Instruction>(code.begin() + 1, end);
+    }
+
+    std::vector<Operation> ops(const std::vector<Instruction>& code) {
+        std::vector<Operation> v;
+        for (auto& i : code)
+            v.push_back(i.GetOperation());
+        return v;
+    }
+
+    // 折叠前后运行结果（输出和运行时错误）都相同，折叠后执行的指令不更多
+    void checkSameRun(const SourceBuffer& src) {
+        auto folded = compile(src, true);
+        auto unfolded = compile(src, false);
+        auto a = test::Execute(folded);
+        auto b = test::Execute(unfolded);
+        CHECK(a.output == b.output);
+        CHECK(a.error == b.error);
+        CHECK(a.executed <= b.executed);
+    }
+}
+
+TEST_CASE("folded and unfolded tests/fold programs behave the same", "[fold]") {
+    auto files = test::Files("tests/fold", ".c0");
+    REQUIRE_FALSE(files.empty());
+    for (auto& path : files) {
+        INFO(path);
+        auto src = SourceBuffer::FromFile(path);
+        REQUIRE(src.has_value());
+        checkSameRun(src.value());
+    }
+}
+
+TEST_CASE("folding is turned off by the Analyser option", "[fold]") {
+    CHECK(ops(exprCode("2 * 3 * x", false)) == std::vector<Operation>{ LOADC, LOADC, IMUL, LOADA, ILOAD, IMUL });
+    CHECK(ops(exprCode("1 + 2", false)) == std::vector<Operation>{ LOADC, LOADC, IADD });
+    CHECK(ops(exprCode("-(3)", false)) == std::vector<Operation>{ LOADC, INEG });
+}
+
+TEST_CASE("constant prefixes are folded", "[fold]") {
+    CHECK(exprCode("2 * 3 * x", true) == std::vector<Instruction>{ { IPUSH, 6 }, { LOADA, 0, 0 }, { ILOAD, 0 }, { IMUL, 0 } });
+    // 只折叠从左边起的常量，x * 2 * 3 不会重排
+    CHECK(ops(exprCode("x * 2 * 3", true)) == std::vector<Operation>{ LOADA, ILOAD, LOADC, IMUL, LOADC, IMUL });
+    CHECK(exprCode("-(3)", true) == std::vector<Instruction>{ { IPUSH, -3 } });
+    CHECK(exprCode("-(2 * 3) + 1", true) == std::vector<Instruction>{ { IPUSH, -5 } });
+    CHECK(exprCode("-7 / 2", true) == std::vector<Instruction>{ { IPUSH, -3 } });
+    // 单独的字面量不折叠，仍然是 loadc
+    CHECK(ops(exprCode("3", true)) == std::vector<Operation>{ LOADC });
+}
+
+TEST_CASE("folding wraps around like the virtual machine", "[fold]") {
+    CHECK(exprCode("2147483647 + 1", true) == std::vector<Instruction>{ { IPUSH, INT32_MIN } });
+    CHECK(exprCode("0 - 2147483647 - 1 - 1", true) == std::vector<Instruction>{ { IPUSH, INT32_MAX } });
+    CHECK(exprCode("65536 * 65536", true) == std::vector<Instruction>{ { IPUSH, 0 } });
+    CHECK(exprCode("-(0 - 2147483647 - 1)", true) == std::vector<Instruction>{ { IPUSH, INT32_MIN } });
+    checkSameRun(test::Source("int main() { print(2147483647 + 1, 0 - 2147483647 - 1 - 1, 65536 * 65537, -(0 - 2147483647 - 1)); return 0; }"));
+}
+
+TEST_CASE("division that fails at run time is not folded", "[fold]") {
+    auto code = ops(exprCode("(0 - 2147483647 - 1) / -1", true));
+    CHECK(code == std::vector<Operation>{ IPUSH, LOADC, INEG, IDIV });
+    CHECK(ops(exprCode("7 / 0", true)) == std::vector<Operation>{ LOADC, LOADC, IDIV });
+    CHECK(ops(exprCode("2 * 3 / 0 * 4", true)) == std::vector<Operation>{ IPUSH, LOADC, IDIV, LOADC, IMUL });
+
+    auto overflow = test::Source("int main() { print(1); print((0 - 2147483647 - 1) / -1); return 0; }");
+    CHECK(test::Execute(compile(overflow, true)).error == "division overflow");
+    checkSameRun(overflow);
+    auto zero = test::Source("const int Z = 3 - 3; int main() { print(1); print(7 / Z); return 0; }");
+    CHECK(test::Execute(compile(zero, true)).error == "division by zero");
+    checkSameRun(zero);
+}
+
+TEST_CASE("negated parenthesized expressions and calls apply the sign last", "[fold]") {
+    for (bool fold : { true, false }) {
+        auto src = test::Source("int f(int a) { return a + 1; } int main() { int x = 4; print(-(x), -(x + 1), -f(x), -(3)); return 0; }");
+        auto r = test::Execute(compile(src, fold));
+        CHECK(r.error.empty());
+        CHECK(r.output == "-4 -5 -5 -3\n");
+    }
+}
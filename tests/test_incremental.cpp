@@ -0,0 +1,122 @@
+#include "catch2/catch.hpp"
+#include "tests/support.hpp"
+#include "tokenizer/incremental.h"
+#include "tokenizer/token_cache.h"
+#include "tokenizer/tokenizer.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace miniplc0;
+
+namespace {
+    // 插入的片段，覆盖注释、数字、标识符、运算符和会出错的输入
+    const std::vector<std::string> snippets = {
+        " ", "\n", "\t", "a", "int", "x1", "0", "7", "0x", "0x1f", "2147483648", "+", "-", "<", "=", "!", "!=",
+        "(", ")", "{", "}", ";", ",", "/", "*", "/*", "*/", "//", "/* c */", "// c\n", "@",
+    };
+
+    struct Edited {
+        std::string text;
+        SourceEdit edit;
+    };
+
+    // 在 text 上随机做一次插入、删除或替换
+    Edited randomEdit(std::mt19937& rng, const std::string& text) {
+        auto begin = static_cast<std::uint32_t>(rng() % (text.size() + 1));
+        auto removed = static_cast<std::uint32_t>(std::min<std::size_t>(rng() % 8 == 0 ? rng() % 40 : rng() % 4, text.size() - begin));
+        std::string inserted;
+        for (auto n = rng() % 3; n > 0; n--)
+            inserted += snippets[rng() % snippets.size()];
+        auto now = text.substr(0, begin) + inserted + text.substr(begin + removed);
+        return Edited{ now, SourceEdit{ begin, begin + removed, static_cast<std::uint32_t>(begin + inserted.size()) } };
+    }
+
+    void checkSameResult(const std::pair<TokenStream, std::optional<CompilationError>>& got,
+                         const std::pair<TokenStream, std::optional<CompilationError>>& expect) {
+        CHECK(test::SameTokens(got.first, expect.first));
+        REQUIRE(got.second.has_value() == expect.second.has_value());
+        if (got.second.has_value()) {
+            CHECK(got.second.value().GetCode() == expect.second.value().GetCode());
+            CHECK(got.second.value().GetOffset() == expect.second.value().GetOffset());
+        }
+    }
+}
+
+TEST_CASE("FindEdit finds the changed range", "[incremental]") {
+    auto edit = [](const std::string& a, const std::string& b) { return FindEdit(a, test::Source(b)); };
+    // SourceBuffer 总是以 \n 结尾
+    auto e = edit("int a;\n", "int ab;\n");
+    CHECK((e.begin == 5 && e.old_end == 5 && e.new_end == 6));
+    e = edit("aaa\n", "aa\n");
+    CHECK((e.begin == 2 && e.old_end == 3 && e.new_end == 2));
+    e = edit("abc\n", "abc\n");
+    CHECK((e.begin == 4 && e.old_end == 4 && e.new_end == 4));
+    e = edit("x = 1;\n", "y = 2;\n");
+    CHECK((e.begin == 0 && e.old_end == 5 && e.new_end == 5));
+}
+
+// 连续编辑时每次都在上一次的结果上增量分析，间隙会在不同的位置之间来回移动
+TEST_CASE("retokenizing after random edits matches a full lex", "[incremental]") {
+    std::mt19937 rng(20191017);
+    for (auto& path : test::Files("examples", ".c0")) {
+        auto file = SourceBuffer::FromFile(path);
+        REQUIRE(file.has_value());
+        std::string text(file.value().begin(), file.value().size());
+        for (auto engine : { SWITCH_LEXER, TABLE_LEXER }) {
+            // 旧的缓冲区要活到下一次编辑之后
+            auto src = std::make_unique<SourceBuffer>(test::Source(text));
+            auto current = Tokenizer(*src, engine).AllTokenStream();
+            auto cur = text;
+            for (int round = 0; round < 200; round++) {
+                auto next = randomEdit(rng, cur);
+                INFO(path << " round " << round << "\n--- before\n" << cur << "\n--- after\n" << next.text);
+                auto now = std::make_unique<SourceBuffer>(test::Source(next.text));
+                auto expect = Tokenizer(*now, engine).AllTokenStream();
+                // 上一次出错时没有可以复用的 token，从完整的结果重新开始
+                if (current.second.has_value())
+                    current = Tokenizer(*src, engine).AllTokenStream();
+                if (!current.second.has_value()) {
+                    // SourceBuffer 会在末尾补 \n，这时编辑范围要按缓冲区重新找
+                    auto edit = next.edit;
+                    if (src->size() != cur.size() || now->size() != next.text.size())
+                        edit = FindEdit(std::string_view(src->begin(), src->size()), *now);
+                    current = Retokenize(std::move(current.first), *now, edit, engine);
+                    checkSameResult(current, expect);
+                } else
+                    current = std::move(expect);
+                cur = next.text;
+                src = std::move(now);
+            }
+        }
+    }
+}
+
+TEST_CASE("token cache re-tokenizes an edited source", "[incremental]") {
+    auto path = (std::filesystem::temp_directory_path() / "c0_test_cache.tokens").string();
+    auto before = test::Source("int a = 1;\nint main() {\n    print(a);\n}\n");
+    auto after = test::Source("int a = 1;\nint b = 0x10;\nint main() {\n    print(a, b); /* x */\n}\n");
+    REQUIRE(SaveTokenCache(path, Tokenizer(before).AllTokenStream().first));
+    // 源码没变时直接复用
+    auto same = LoadTokenCache(path, before);
+    REQUIRE(same.has_value());
+    CHECK(test::SameTokens(same.value(), Tokenizer(before).AllTokenStream().first));
+    CHECK(!LoadTokenCache(path, after).has_value());
+    auto relexed = RelexTokenCache(path, after, SWITCH_LEXER);
+    REQUIRE(relexed.has_value());
+    CHECK(test::SameTokens(relexed.value(), Tokenizer(after).AllTokenStream().first));
+    // 带间隙的 token 序列写进缓存后也能原样读回来
+    REQUIRE(SaveTokenCache(path, relexed.value()));
+    auto reloaded = LoadTokenCache(path, after);
+    REQUIRE(reloaded.has_value());
+    CHECK(test::SameTokens(reloaded.value(), relexed.value()));
+    // 有词法错误时交给完整的词法分析
+    auto bad = test::Source("int a = 1;\nint main() {\n    print(a); @\n}\n");
+    CHECK(!RelexTokenCache(path, bad, SWITCH_LEXER).has_value());
+    std::remove(path.c_str());
+}
@@ -0,0 +1,75 @@
+#include "catch2/catch.hpp"
+#include "tests/support.hpp"
+#include "tokenizer/tokenizer.h"
+
+#include <string>
+#include <vector>
+
+using namespace miniplc0;
+
+namespace {
+    // 两种实现分析同一个缓冲区，token 序列和错误都必须相同
+    void checkSameLexers(const SourceBuffer& src) {
+        auto a = Tokenizer(src, SWITCH_LEXER).AllTokenStream();
+        auto b = Tokenizer(src, TABLE_LEXER).AllTokenStream();
+        CHECK(test::SameTokens(a.first, b.first));
+        REQUIRE(a.second.has_value() == b.second.has_value());
+        if (a.second.has_value()) {
+            CHECK(a.second.value().GetCode() == b.second.value().GetCode());
+            CHECK(a.second.value().GetOffset() == b.second.value().GetOffset());
+        }
+    }
+}
+
+TEST_CASE("switch and table lexers agree on examples/", "[lexer]") {
+    for (auto ext : { ".c0", ".c" })
+        for (auto& path : test::Files("examples", ext)) {
+            INFO(path);
+            auto src = SourceBuffer::FromFile(path);
+            REQUIRE(src.has_value());
+            checkSameLexers(src.value());
+        }
+}
+
+TEST_CASE("switch and table lexers agree on edge cases", "[lexer]") {
+    std::vector<std::string> cases = {
+        // 十进制和十六进制溢出
+        "int a = 2147483647;",
+        "int a = 2147483648;",
+        "int a = 99999999999999999999;",
+        "int a = 0x7fffffff;",
+        "int a = 0xffffffff;",
+        "int a = 0x100000000;",
+        "int a = 0X1aBcD;",
+        // 0x 后面没有数字
+        "int a = 0x;",
+        "int a = 0x\n",
+        "0xfg",
+        // 数字开头的标识符
+        "int 1abc = 0;",
+        "123abc",
+        "0abc",
+        "007",
+        // 单独的 !
+        "a ! b",
+        "a != b",
+        "!",
+        // 注释
+        "// line comment\nint a;",
+        "/* block */ int /* x */ a;",
+        "/* unfinished",
+        "a / b /* c */ / d",
+        "/**/",
+        // 非 ASCII 输入
+        "int \xe5\x8f\x98\xe9\x87\x8f = 1;",
+        "\x80",
+        // 运算符和空白
+        "a<=b>=c==d<e>f=g",
+        "\t\r\n  \v\f",
+        "",
+    };
+    for (auto& text : cases) {
+        INFO(text);
+        checkSameLexers(test::Source(text));
+    }
+}
@@ -0,0 +1,4 @@
+// glibc 2.34 以后 MINSIGSTKSZ 不再是常量，Catch 2.9 的信号处理在新系统上编译不过
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
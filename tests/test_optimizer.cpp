@@ -0,0 +1,163 @@
+#include "catch2/catch.hpp"
+#include "tests/support.hpp"
+#include "tests/vm.hpp"
+#include "analyser/analyser.h"
+#include "optimizer/optimizer.h"
+#include "optimizer/cfg.h"
+#include "optimizer/loop.h"
+#include "optimizer/jump.h"
+#include "tokenizer/tokenizer.h"
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace miniplc0;
+
+namespace {
+    std::optional<Program> compile(const SourceBuffer& src) {
+        Tokenizer tkz(src);
+        auto r = Analyser(tkz).Analyse();
+        if (r.error.has_value())
+            return {};
+        return std::move(r.program);
+    }
+
+    Program compile(const std::string& text) {
+        auto p = compile(test::Source(text));
+        REQUIRE(p.has_value());
+        return std::move(p.value());
+    }
+
+    // tests/opt 和 examples 里能通过编译的程序
+    std::vector<std::pair<std::string, Program>> corpus() {
+        std::vector<std::pair<std::string, Program>> programs;
+        for (auto dir : { "tests/opt", "examples" })
+            for (auto& path : test::Files(dir, ".c0")) {
+                auto src = SourceBuffer::FromFile(path);
+                REQUIRE(src.has_value());
+                auto p = compile(src.value());
+                if (p.has_value())
+                    programs.emplace_back(path, std::move(p.value()));
+            }
+        return programs;
+    }
+
+    // 向后跳的条件跳转数，旋转后的循环每个有一条
+    std::size_t backwardBranches(const std::vector<Instruction>& code) {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < code.size(); i++)
+            if (IsJump(code[i].GetOperation()) && code[i].GetOperation() != JMP && static_cast<std::size_t>(code[i].GetX()) <= i)
+                n++;
+        return n;
+    }
+}
+
+TEST_CASE("Layout() reproduces every function of the corpus", "[optimizer]") {
+    auto programs = corpus();
+    REQUIRE(programs.size() >= 4);
+    for (auto& [path, program] : programs) {
+        INFO(path);
+        for (auto& code : program.codes()) {
+            ControlFlowGraph cfg(code);
+            CHECK(cfg.Layout() == code);
+            for (std::size_t b = 0; b < cfg.size(); b++)
+                for (auto s : cfg[b].succs)
+                    CHECK(std::count(cfg[s].preds.begin(), cfg[s].preds.end(), b) == 1);
+        }
+    }
+}
+
+TEST_CASE("jumps past the end go to an empty exit block", "[optimizer]") {
+    std::vector<Instruction> code{ { IPUSH, 1 }, { JE, 4 }, { IPUSH, 2 }, { IPRINT, 0 } };
+    ControlFlowGraph cfg(code);
+    REQUIRE(cfg.size() == 3);
+    CHECK(cfg[2].code.empty());
+    CHECK(cfg[0].code.back().GetX() == 2);
+    CHECK(cfg[1].fallthrough == std::optional<std::size_t>(2));
+    CHECK(cfg[2].preds == std::vector<std::size_t>{ 0, 1 });
+    CHECK(cfg.Layout() == code);
+}
+
+TEST_CASE("Layout jumps to the entry when it is not placed first", "[optimizer]") {
+    std::vector<Instruction> code{ { JMP, 2 }, { IPUSH, 1 }, { RET, 0 } };
+    ControlFlowGraph cfg(code);
+    REQUIRE(cfg.size() == 3);
+    CHECK(cfg.Reachable() == std::vector<bool>{ true, false, true });
+    CHECK(cfg.Layout({ 2, 0 }) == std::vector<Instruction>{ { JMP, 2 }, { RET, 0 }, { JMP, 1 } });
+    // 入口在最前面时不补 jmp，fallthrough 不紧跟在后面时补一条
+    CHECK(cfg.Layout({ 0, 2 }) == std::vector<Instruction>{ { JMP, 1 }, { RET, 0 } });
+}
+
+TEST_CASE("nested and consecutive loops are rotated", "[optimizer]") {
+    auto nested = compile("int main() { int i = 0; int j; int s = 0; while (i < 3) { j = 0; while (j < i) { s = s + j; j = j + 1; } i = i + 1; } print(s); return 0; }");
+    auto code = nested.codes()[1];
+    CHECK(backwardBranches(code) == 0);
+    CHECK(RotateLoops(code) == 2);
+    CHECK(backwardBranches(code) == 2);
+
+    auto consecutive = compile("int main() { int i = 0; while (i < 3) i = i + 1; while (i > 0) i = i - 1; while (i < 0) {} print(i); return 0; }");
+    code = consecutive.codes()[1];
+    CHECK(RotateLoops(code) == 3);
+    CHECK(backwardBranches(code) == 3);
+
+    // 条件块是入口时，开头补一条跳到条件的 jmp
+    code = { { IPUSH, 0 }, { JE, 3 }, { JMP, 0 }, { RET, 0 } };
+    CHECK(RotateLoops(code) == 1);
+    CHECK(code == std::vector<Instruction>{ { JMP, 1 }, { IPUSH, 0 }, { JNE, 1 }, { RET, 0 } });
+}
+
+TEST_CASE("jump threading terminates on while (1) {}", "[optimizer]") {
+    std::vector<Instruction> code{ { JMP, 0 } };
+    ThreadJumps(code);
+    CHECK(code == std::vector<Instruction>{ { JMP, 0 } });
+
+    // 两个 jmp 互相跳，串联时不能一直绕下去，结果仍然是死循环
+    code = { { JMP, 1 }, { JMP, 2 }, { JMP, 1 } };
+    ThreadJumps(code);
+    REQUIRE_FALSE(code.empty());
+    for (auto& ins : code) {
+        CHECK(ins.GetOperation() == JMP);
+        CHECK(static_cast<std::size_t>(ins.GetX()) < code.size());
+    }
+
+    auto forever = compile("int main() { print(1); while (1) {} return 0; }");
+    auto optimized = forever;
+    Optimize(optimized, 1);
+    auto a = test::Execute(forever, {}, 10000);
+    auto b = test::Execute(optimized, {}, 10000);
+    CHECK(a.output == "1\n");
+    CHECK(b.output == a.output);
+    CHECK(b.error == "instruction limit");
+}
+
+TEST_CASE("a conditional jump to the next instruction becomes pop", "[optimizer]") {
+    std::vector<Instruction> code{ { IPUSH, 1 }, { JE, 2 }, { RET, 0 } };
+    ThreadJumps(code);
+    CHECK(code == std::vector<Instruction>{ { IPUSH, 1 }, { POP, 0 }, { RET, 0 } });
+
+    // if (x) {} 的两个去向相同
+    auto p = compile("int main() { int x = 2; if (x) {} print(x); return 0; }");
+    Optimize(p, 1);
+    auto& main = p.codes()[1];
+    CHECK(std::count_if(main.begin(), main.end(), [](const Instruction& i) { return IsJump(i.GetOperation()); }) == 0);
+    CHECK(std::count_if(main.begin(), main.end(), [](const Instruction& i) { return i.GetOperation() == POP; }) == 1);
+    CHECK(test::Execute(p).output == "2\n");
+}
+
+TEST_CASE("-O1 code behaves like -O0 code on the corpus", "[optimizer]") {
+    for (auto& [path, program] : corpus()) {
+        INFO(path);
+        auto optimized = program;
+        Optimize(optimized, 1);
+        auto a = test::Execute(program, { 5, 3, 7 });
+        auto b = test::Execute(optimized, { 5, 3, 7 });
+        CHECK(a.error.empty());
+        CHECK(b.output == a.output);
+        CHECK(b.error == a.error);
+        CHECK(b.executed <= a.executed);
+        for (std::size_t f = 0; f < program.codes().size(); f++)
+            CHECK(optimized.codes()[f].size() <= program.codes()[f].size());
+    }
+}
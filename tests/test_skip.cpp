@@ -0,0 +1,59 @@
+#include "catch2/catch.hpp"
+#include "tokenizer/skip.hpp"
+
+#include <random>
+#include <string>
+
+using namespace miniplc0;
+
+namespace {
+    // 逐字符的参考实现
+    const char* blanks(const char* p, const char* end) {
+        while (p != end && skip::isBlank(*p))
+            ++p;
+        return p;
+    }
+
+    const char* lineEnd(const char* p, const char* end) {
+        while (p != end && *p != '\n' && *p != '\r')
+            ++p;
+        return p;
+    }
+
+    const char* blockEnd(const char* p, const char* end) {
+        for (; end - p >= 2; ++p)
+            if (p[0] == '*' && p[1] == '/')
+                return p;
+        return end;
+    }
+
+    // 长度 n 的随机串，大部分是 fill，偶尔出现 rare 中的字符
+    std::string random(std::mt19937& rng, std::size_t n, char fill, const std::string& rare) {
+        std::string s(n, fill);
+        for (auto& ch : s)
+            if (rng() % 40 == 0)
+                ch = rare[rng() % rare.size()];
+        return s;
+    }
+}
+
+// 不管走的是 AVX2、SSE2 还是逐字符的循环，结果都要和参考实现一样
+// 长度覆盖向量宽度附近，起点覆盖不对齐的情况
+TEST_CASE("skip functions match the scalar reference", "[lexer]") {
+    std::mt19937 rng(20191017);
+    for (std::size_t n = 0; n < 140; n++)
+        for (int round = 0; round < 8; round++) {
+            auto ws = random(rng, n, ' ', "\t\n\rx");
+            auto line = random(rng, n, 'a', "\n\r ");
+            auto block = random(rng, n, 'b', "*/");
+            for (std::size_t from = 0; from <= n && from < 5; from++) {
+                INFO("n = " << n << ", from = " << from);
+                auto end = ws.data() + n;
+                CHECK(skip::Blanks(ws.data() + from, end) == blanks(ws.data() + from, end));
+                end = line.data() + n;
+                CHECK(skip::LineEnd(line.data() + from, end) == lineEnd(line.data() + from, end));
+                end = block.data() + n;
+                CHECK(skip::BlockEnd(block.data() + from, end) == blockEnd(block.data() + from, end));
+            }
+        }
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "analyser/analyser.h"
+#include "instruction/instruction.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// 按虚拟机的语义解释执行 Program，用来比较不同编译选项生成的代码是否等价
+// 全局量在栈底，loada 1 相对栈底、loada 0 相对当前函数的 bp；加、减、乘、取负回绕，除法向 0 取整
+namespace test {
+
+    struct Run {
+        std::string output;
+        // 执行的指令条数
+        std::uint64_t executed = 0;
+        // 运行时错误，为空表示正常结束
+        std::string error;
+    };
+
+    class VM {
+        private:
+            using int32_t = std::int32_t;
+            using uint32_t = std::uint32_t;
+        public:
+            VM(const miniplc0::Program& program, std::vector<int32_t> input, std::uint64_t limit)
+                    : _program(program), _input(std::move(input)), _next(0), _limit(limit) {}
+
+            // 先执行 .start，再执行 main
+            Run Execute() {
+                execute(_program.start(), 0);
+                if (!_run.error.empty())
+                    return _run;
+                const auto& cons = _program.cons();
+                const auto& funcs = _program.funcs();
+                for (std::size_t i = 0; i < funcs.size(); i++)
+                    if (cons[funcs[i].nameindex].type == 1 && cons[funcs[i].nameindex].str == "main") {
+                        execute(_program.codes()[i + 1], _stack.size());
+                        return _run;
+                    }
+                _run.error = "no main";
+                return _run;
+            }
+        private:
+            bool fail(const char* what) {
+                if (_run.error.empty())
+                    _run.error = what;
+                return false;
+            }
+
+            bool pop(int32_t& v) {
+                if (_stack.empty())
+                    return fail("stack underflow");
+                v = _stack.back();
+                _stack.pop_back();
+                return true;
+            }
+
+            bool address(int32_t a) {
+                return a >= 0 && static_cast<std::size_t>(a) < _stack.size() ? true : fail("bad address");
+            }
+
+            // 执行一个函数，返回 false 表示出错；函数有返回值时留在 _ret 里
+            bool execute(const std::vector<miniplc0::Instruction>& code, std::size_t bp) {
+                using namespace miniplc0;
+                if (++_depth > 10000)
+                    return fail("call depth");
+                std::size_t pc = 0;
+                int32_t l, r;
+                while (true) {
+                    // .start 执行到末尾就结束
+                    if (pc == code.size() && &code == &_program.start())
+                        break;
+                    if (pc >= code.size())
+                        return fail("pc out of range");
+                    if (++_run.executed > _limit)
+                        return fail("instruction limit");
+                    auto& ins = code[pc++];
+                    switch (ins.GetOperation()) {
+                        case IPUSH: _stack.push_back(ins.GetX()); break;
+                        case LOADC: {
+                            auto& c = _program.cons().at(ins.GetX());
+                            if (c.type != 0)
+                                return fail("loadc string");
+                            _stack.push_back(c.value);
+                            break;
+                        }
+                        case LOADA:
+                            _stack.push_back(static_cast<int32_t>(ins.GetX() == 1 ? ins.GetY() : bp + ins.GetY()));
+                            break;
+                        case ILOAD:
+                            if (!pop(l) || !address(l))
+                                return false;
+                            _stack.push_back(_stack[l]);
+                            break;
+                        case ISTORE:
+                            if (!pop(r) || !pop(l) || !address(l))
+                                return false;
+                            _stack[l] = r;
+                            break;
+                        case IADD: case ISUB: case IMUL: case IDIV:
+                            if (!pop(r) || !pop(l))
+                                return false;
+                            if (ins.GetOperation() == IDIV) {
+                                if (r == 0)
+                                    return fail("division by zero");
+                                if (l == INT32_MIN && r == -1)
+                                    return fail("division overflow");
+                                _stack.push_back(l / r);
+                            } else if (ins.GetOperation() == IADD)
+                                _stack.push_back(static_cast<int32_t>(static_cast<uint32_t>(l) + static_cast<uint32_t>(r)));
+                            else if (ins.GetOperation() == ISUB)
+                                _stack.push_back(static_cast<int32_t>(static_cast<uint32_t>(l) - static_cast<uint32_t>(r)));
+                            else
+                                _stack.push_back(static_cast<int32_t>(static_cast<uint32_t>(l) * static_cast<uint32_t>(r)));
+                            break;
+                        case INEG:
+                            if (!pop(l))
+                                return false;
+                            _stack.push_back(static_cast<int32_t>(0u - static_cast<uint32_t>(l)));
+                            break;
+                        case IPRINT:
+                            if (!pop(l))
+                                return false;
+                            _run.output += std::to_string(l);
+                            break;
+                        case CPRINT:
+                            if (!pop(l))
+                                return false;
+                            _run.output.push_back(static_cast<char>(l));
+                            break;
+                        case PRINTL: _run.output.push_back('\n'); break;
+                        case ISCAN: _stack.push_back(_next < _input.size() ? _input[_next++] : 0); break;
+                        case POPN:
+                            if (ins.GetX() < 0 || _stack.size() < bp + ins.GetX())
+                                return fail("popn underflow");
+                            _stack.resize(_stack.size() - ins.GetX());
+                            break;
+                        case POP:
+                            if (!pop(l))
+                                return false;
+                            break;
+                        case JMP: pc = ins.GetX(); break;
+                        case JE: case JNE: case JL: case JGE: case JG: case JLE: {
+                            if (!pop(l))
+                                return false;
+                            bool taken = false;
+                            switch (ins.GetOperation()) {
+                                case JE: taken = l == 0; break;
+                                case JNE: taken = l != 0; break;
+                                case JL: taken = l < 0; break;
+                                case JGE: taken = l >= 0; break;
+                                case JG: taken = l > 0; break;
+                                default: taken = l <= 0; break;
+                            }
+                            if (taken)
+                                pc = ins.GetX();
+                            break;
+                        }
+                        case CALL: {
+                            auto index = static_cast<std::size_t>(ins.GetX());
+                            if (index >= _program.funcs().size())
+                                return fail("bad function");
+                            auto n = static_cast<std::size_t>(_program.funcs()[index].getParaSize());
+                            if (_stack.size() < n)
+                                return fail("stack underflow");
+                            auto callee = _stack.size() - n;
+                            _ret.reset();
+                            if (!execute(_program.codes()[index + 1], callee))
+                                return false;
+                            _stack.resize(callee);
+                            if (_ret.has_value())
+                                _stack.push_back(_ret.value());
+                            break;
+                        }
+                        case RET:
+                            _ret.reset();
+                            _depth--;
+                            return true;
+                        case IRET:
+                            if (!pop(l))
+                                return false;
+                            _ret = l;
+                            _depth--;
+                            return true;
+                        default:
+                            return fail("unknown instruction");
+                    }
+                    if (_stack.size() > (1u << 22))
+                        return fail("stack overflow");
+                }
+                _depth--;
+                return true;
+            }
+        private:
+            const miniplc0::Program& _program;
+            std::vector<int32_t> _input;
+            std::size_t _next;
+            std::uint64_t _limit;
+            std::vector<int32_t> _stack;
+            std::optional<int32_t> _ret;
+            int _depth = 0;
+            Run _run;
+    };
+
+    inline Run Execute(const miniplc0::Program& program, std::vector<std::int32_t> input = {}, std::uint64_t limit = 50000000) {
+        return VM(program, std::move(input), limit).Execute();
+    }
+}
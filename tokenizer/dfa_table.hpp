@@ -0,0 +1,188 @@
+#pragma once
+
+#include "tokenizer/token.h"
+
+#include <cstdint>
+#include <cstddef>
+
+// 查表实现的词法分析器用到的状态转移表，全部在编译期生成
+// 1.状态转移表是 [状态][256] 的 uint8，每个字符直接作为列下标，不需要再判断字符类型
+// 2.转移的结果小于 states 时是下一个状态，否则是一个接受动作，动作编号是结果减去 states
+// 3.每个动作记录接受时多读了几个字符，需要回退
+// 和 Tokenizer::nextToken 中手写的状态机一一对应，两者必须产生相同的 token 序列
+namespace miniplc0 {
+	namespace dfa {
+
+		// 状态，START 之前的空白字符已经跳过
+		enum State : std::uint8_t {
+			START,
+			// 读到了 0
+			ZERO,
+			// 读到了 0x
+			ZERO_X,
+			HEX,
+			DEC,
+			IDENT,
+			// 读到了 =
+			ASSIGN,
+			// 读到了 <
+			LESS,
+			// 读到了 >
+			GREATER,
+			// 读到了 !
+			BANG,
+			// 读到了 /
+			SLASH,
+			states
+		};
+
+		// 接受动作
+		enum Action : std::uint8_t {
+			// 下面这些直接产生 kind 中对应类型的 token
+			A_SIMPLE_BEGIN,
+			A_PLUS = A_SIMPLE_BEGIN,
+			A_MINUS,
+			A_MUL,
+			A_DIV,
+			A_ASSIGN,
+			A_EQUAL,
+			A_LESS,
+			A_LESS_EQUAL,
+			A_GREATER,
+			A_GREATER_EQUAL,
+			A_NOT_EQUAL,
+			A_LEFT_BRACKET,
+			A_RIGHT_BRACKET,
+			A_LEFT_BRACE,
+			A_RIGHT_BRACE,
+			A_SEMICOLON,
+			A_COMMA,
+			// 单独的 0
+			A_ZERO,
+			A_SIMPLE_END,
+			// 需要解析的字面量
+			A_DEC = A_SIMPLE_END,
+			A_HEX,
+			// 标识符或者关键字
+			A_IDENT,
+			// 注释，跳过之后重新开始
+			A_LINE_COMMENT,
+			A_BLOCK_COMMENT,
+			// 非法输入
+			A_INVALID,
+			actions
+		};
+		static_assert(states + actions <= 256, "dfa table entries must fit in uint8.");
+
+		struct ActionInfo {
+			TokenType kind;
+			// 接受时需要回退的字符数
+			std::uint8_t backtrack;
+		};
+
+		constexpr ActionInfo action_info[actions] = {
+			{ PLUS_SIGN, 0 },
+			{ MINUS_SIGN, 0 },
+			{ MULTIPLICATION_SIGN, 0 },
+			{ DIVISION_SIGN, 1 },
+			{ EQUAL_SIGN, 1 },
+			{ EQUAL, 0 },
+			{ SMALL, 1 },
+			{ SMALL_EQUAL, 0 },
+			{ BIG, 1 },
+			{ BIG_EQUAL, 0 },
+			{ NOT_EQUAL, 0 },
+			{ LEFT_BRACKET, 0 },
+			{ RIGHT_BRACKET, 0 },
+			{ LEFT_BRACE, 0 },
+			{ RIGHT_BRACE, 0 },
+			{ SEMICOLON, 0 },
+			{ COMMA, 0 },
+			{ UNSIGNED_INTEGER, 1 },
+			{ UNSIGNED_INTEGER, 1 },
+			{ UNSIGNED_HEX_INTEGER, 1 },
+			{ IDENTIFIER, 1 },
+			{ NULL_TOKEN, 0 },
+			{ NULL_TOKEN, 0 },
+			{ NULL_TOKEN, 1 },
+		};
+
+		// 和 tokenizer/utils.hpp 一致，但是可以在编译期使用
+		constexpr bool isDigit(unsigned c) { return c >= '0' && c <= '9'; }
+		constexpr bool isAlpha(unsigned c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+		constexpr bool isXDigit(unsigned c) { return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'); }
+
+		constexpr std::uint8_t accept(Action a) { return static_cast<std::uint8_t>(states + a); }
+
+		struct Table {
+			std::uint8_t next[states][256];
+		};
+
+		constexpr Table build() {
+			Table t = {};
+			// 默认：START 遇到不认识的字符是非法输入，其他状态遇到不认识的字符就接受
+			for (unsigned c = 0; c < 256; c++) {
+				t.next[START][c] = accept(A_INVALID);
+				t.next[ZERO][c] = accept(A_ZERO);
+				t.next[ZERO_X][c] = accept(A_INVALID);
+				t.next[HEX][c] = accept(A_HEX);
+				t.next[DEC][c] = accept(A_DEC);
+				t.next[IDENT][c] = accept(A_IDENT);
+				t.next[ASSIGN][c] = accept(A_ASSIGN);
+				t.next[LESS][c] = accept(A_LESS);
+				t.next[GREATER][c] = accept(A_GREATER);
+				t.next[BANG][c] = accept(A_INVALID);
+				t.next[SLASH][c] = accept(A_DIV);
+			}
+			for (unsigned c = 0; c < 256; c++) {
+				if (isDigit(c)) {
+					t.next[START][c] = c == '0' ? ZERO : DEC;
+					t.next[DEC][c] = DEC;
+					t.next[HEX][c] = HEX;
+					t.next[ZERO_X][c] = HEX;
+					t.next[IDENT][c] = IDENT;
+				}
+				if (isAlpha(c)) {
+					t.next[START][c] = IDENT;
+					t.next[IDENT][c] = IDENT;
+					// 数字后面紧跟字母，按标识符读完再报错
+					t.next[DEC][c] = IDENT;
+					t.next[HEX][c] = isXDigit(c) ? HEX : IDENT;
+					if (isXDigit(c))
+						t.next[ZERO_X][c] = HEX;
+				}
+			}
+			t.next[ZERO]['x'] = ZERO_X;
+			t.next[ZERO]['X'] = ZERO_X;
+
+			t.next[START]['='] = ASSIGN;
+			t.next[START]['<'] = LESS;
+			t.next[START]['>'] = GREATER;
+			t.next[START]['!'] = BANG;
+			t.next[START]['/'] = SLASH;
+			t.next[ASSIGN]['='] = accept(A_EQUAL);
+			t.next[LESS]['='] = accept(A_LESS_EQUAL);
+			t.next[GREATER]['='] = accept(A_GREATER_EQUAL);
+			t.next[BANG]['='] = accept(A_NOT_EQUAL);
+			t.next[SLASH]['/'] = accept(A_LINE_COMMENT);
+			t.next[SLASH]['*'] = accept(A_BLOCK_COMMENT);
+
+			t.next[START]['+'] = accept(A_PLUS);
+			t.next[START]['-'] = accept(A_MINUS);
+			t.next[START]['*'] = accept(A_MUL);
+			t.next[START]['('] = accept(A_LEFT_BRACKET);
+			t.next[START][')'] = accept(A_RIGHT_BRACKET);
+			t.next[START]['{'] = accept(A_LEFT_BRACE);
+			t.next[START]['}'] = accept(A_RIGHT_BRACE);
+			t.next[START][';'] = accept(A_SEMICOLON);
+			t.next[START][','] = accept(A_COMMA);
+			return t;
+		}
+
+		constexpr Table table = build();
+
+		static_assert(table.next[START]['0'] == ZERO && table.next[ZERO]['1'] == accept(A_ZERO), "dfa table is broken.");
+		static_assert(table.next[HEX]['f'] == HEX && table.next[HEX]['g'] == IDENT, "dfa table is broken.");
+		static_assert(table.next[START][0x80] == accept(A_INVALID), "dfa table is broken.");
+	}
+}
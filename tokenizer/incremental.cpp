@@ -0,0 +1,68 @@
+#include "tokenizer/incremental.h"
+
+#include <algorithm>
+
+namespace miniplc0 {
+
+	SourceEdit FindEdit(std::string_view before, const SourceBuffer& after) {
+		std::string_view now(after.begin(), after.size());
+		auto n = std::min(before.size(), now.size());
+		std::size_t prefix = std::mismatch(before.begin(), before.begin() + n, now.begin()).first - before.begin();
+		// 后缀不能和前缀重叠
+		std::size_t suffix = 0;
+		while (suffix < n - prefix && before[before.size() - 1 - suffix] == now[now.size() - 1 - suffix])
+			suffix++;
+		return SourceEdit{ static_cast<std::uint32_t>(prefix), static_cast<std::uint32_t>(before.size() - suffix),
+			static_cast<std::uint32_t>(now.size() - suffix) };
+	}
+
+	std::pair<TokenStream, std::optional<CompilationError>>
+	Retokenize(TokenStream&& old, const SourceBuffer& src, const SourceEdit& edit, LexerEngine engine) {
+		if (edit.begin > edit.old_end || edit.begin > edit.new_end || edit.new_end > src.size())
+			DieAndPrint("invalid source edit.");
+		std::int64_t shift = static_cast<std::int64_t>(edit.new_end) - edit.old_end;
+
+		// 编辑之前的字符没有变，token 的开头一定是代码状态，而 token 最多向后多看一个字符
+		// 所以开头在 begin 之前的最后一个 token 之前的 token 都不受影响，从它开始重新分析
+		std::size_t lo = 0, hi = old.size();
+		while (lo < hi) {
+			auto mid = lo + (hi - lo) / 2;
+			if (old.Offset(mid) < edit.begin)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		std::size_t first = lo == 0 ? 0 : lo - 1;
+		std::uint32_t restart = lo == 0 ? 0 : old.Offset(first);
+
+		// 编辑之后第一个旧 token，用来寻找对齐的位置
+		std::size_t last = first;
+		while (last < old.size() && old.Offset(last) < edit.old_end)
+			last++;
+
+		TokenStream fresh(src);
+		Tokenizer tkz(src, restart, src.size(), engine);
+		while (true) {
+			auto p = tkz.NextToken();
+			if (p.second.has_value()) {
+				if (p.second.value().GetCode() != ErrorCode::ErrEOF)
+					return std::make_pair(TokenStream(src), p.second);
+				// 一直到文件尾都没有对齐，旧 token 全部作废
+				last = old.size();
+				break;
+			}
+			auto& t = p.first.value();
+			if (t.GetOffset() >= edit.new_end) {
+				auto at = static_cast<std::int64_t>(t.GetOffset()) - shift;
+				while (last < old.size() && old.Offset(last) < at)
+					last++;
+				// 新旧 token 从同一个输入位置开始，之后的分析完全相同
+				if (last < old.size() && old.Offset(last) == at)
+					break;
+			}
+			fresh.push_back(t);
+		}
+		old.splice(first, last, fresh, shift);
+		return std::make_pair(std::move(old), std::optional<CompilationError>());
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "tokenizer/tokenizer.h"
+#include "tokenizer/token_stream.h"
+#include "tokenizer/source.h"
+#include "error/error.h"
+
+#include <utility>
+#include <string_view>
+#include <optional>
+#include <cstdint>
+
+namespace miniplc0 {
+
+	// 一次编辑：旧源码的 [begin, old_end) 被换成了新源码的 [begin, new_end)
+	struct SourceEdit {
+		std::uint32_t begin;
+		std::uint32_t old_end;
+		std::uint32_t new_end;
+	};
+
+	// 只知道编辑前后的全文时，把相同的前缀和后缀之间的部分当作一次编辑
+	SourceEdit FindEdit(std::string_view before, const SourceBuffer& after);
+
+	// 增量词法分析
+	// old 是编辑前整个源码的 token 序列（不会再读它的原文，旧缓冲区可以已经释放），src 是编辑后的源码
+	// 从编辑位置之前最后一个 token 的开头重新分析，直到新 token 的开头落在编辑之后某个旧 token 的开头上
+	// 从这里起两边的输入和状态都相同，剩下的旧 token 平移偏移后直接复用
+	// old 的存储直接拿来改，后面的 token 平移是 O(1) 的，见 TokenStream::splice
+	// 结果（包括出错时返回的错误）和 Tokenizer(src, engine).AllTokenStream() 完全相同
+	std::pair<TokenStream, std::optional<CompilationError>>
+		Retokenize(TokenStream&& old, const SourceBuffer& src, const SourceEdit& edit, LexerEngine engine = SWITCH_LEXER);
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "tokenizer/token.h"
+
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+// 关键字识别
+// 关键字在 TokenType 里是 CONST 到 SCAN 连续的一段，这里的表按同样的顺序排列
+// 编译期找一个没有冲突的哈希参数，运行时只需要算一次哈希再比一次原文
+namespace miniplc0 {
+	namespace keyword {
+
+		struct Keyword {
+			std::string_view name;
+			TokenType type;
+		};
+
+		constexpr Keyword table[] = {
+			{ "const", CONST },
+			{ "void", VOID },
+			{ "int", INT },
+			{ "char", CHAR },
+			{ "double", DOUBLE },
+			{ "struct", STRUCT },
+			{ "if", IF },
+			{ "else", ELSE },
+			{ "switch", SWITCH },
+			{ "case", CASE },
+			{ "default", DEFAULT },
+			{ "while", WHILE },
+			{ "for", FOR },
+			{ "do", DO },
+			{ "return", RETURN },
+			{ "break", BREAK },
+			{ "continue", CONTINUE },
+			{ "print", PRINT },
+			{ "scan", SCAN },
+		};
+
+		constexpr std::size_t count = sizeof(table) / sizeof(table[0]);
+
+		constexpr bool matchesEnum() {
+			for (std::size_t i = 0; i < count; i++)
+				if (table[i].type != static_cast<TokenType>(CONST + i))
+					return false;
+			return table[count - 1].type == SCAN;
+		}
+		static_assert(matchesEnum(), "keyword table must follow TokenType from CONST to SCAN.");
+
+		constexpr std::size_t min_length() {
+			std::size_t r = table[0].name.size();
+			for (auto& k : table)
+				r = k.name.size() < r ? k.name.size() : r;
+			return r;
+		}
+		constexpr std::size_t max_length() {
+			std::size_t r = 0;
+			for (auto& k : table)
+				r = k.name.size() > r ? k.name.size() : r;
+			return r;
+		}
+
+		// 哈希槽数，必须是 2 的幂
+		constexpr std::uint32_t slots = 64;
+
+		// 只看长度、首字母和末字母，调用者保证 s 非空
+		constexpr std::uint32_t hash(std::string_view s, std::uint32_t seed) {
+			auto first = static_cast<std::uint32_t>(static_cast<unsigned char>(s[0]));
+			auto last = static_cast<std::uint32_t>(static_cast<unsigned char>(s[s.size() - 1]));
+			return ((first * seed) ^ (last * (seed >> 8)) ^ static_cast<std::uint32_t>(s.size())) & (slots - 1);
+		}
+
+		constexpr bool isPerfect(std::uint32_t seed) {
+			bool used[slots] = {};
+			for (auto& k : table) {
+				auto h = hash(k.name, seed);
+				if (used[h])
+					return false;
+				used[h] = true;
+			}
+			return true;
+		}
+
+		constexpr std::uint32_t findSeed() {
+			for (std::uint32_t seed = 0x101; seed < 0x10000; seed++)
+				if (isPerfect(seed))
+					return seed;
+			return 0;
+		}
+
+		constexpr std::uint32_t seed = findSeed();
+		static_assert(seed != 0, "no perfect hash seed for the keyword table.");
+
+		struct Slots {
+			// 关键字在 table 中的下标，-1 表示空槽
+			std::int8_t index[slots];
+		};
+
+		constexpr Slots buildSlots() {
+			Slots r = {};
+			for (auto& i : r.index)
+				i = -1;
+			for (std::size_t i = 0; i < count; i++)
+				r.index[hash(table[i].name, seed)] = static_cast<std::int8_t>(i);
+			return r;
+		}
+
+		constexpr Slots lookup_slots = buildSlots();
+	}
+
+	// 如果 s 是关键字返回对应的 TokenType，否则返回 IDENTIFIER
+	constexpr TokenType KeywordOrIdentifier(std::string_view s) {
+		if (s.size() < keyword::min_length() || s.size() > keyword::max_length())
+			return IDENTIFIER;
+		auto i = keyword::lookup_slots.index[keyword::hash(s, keyword::seed)];
+		if (i < 0 || keyword::table[i].name != s)
+			return IDENTIFIER;
+		return keyword::table[i].type;
+	}
+
+	static_assert(KeywordOrIdentifier("while") == WHILE, "keyword lookup is broken.");
+	static_assert(KeywordOrIdentifier("whale") == IDENTIFIER, "keyword lookup is broken.");
+}
@@ -0,0 +1,138 @@
+#include "tokenizer/parallel.h"
+#include "tokenizer/skip.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace miniplc0 {
+
+	namespace {
+
+		// 从代码状态开始扫描 [p, end)，只关心注释，返回结尾时是否还在块注释里
+		// token 里不会出现 /，所以代码中的 // 和 /* 一定是注释的开始
+		bool endsInComment(const char* p, const char* end) {
+			while (p != end) {
+				p = static_cast<const char*>(std::memchr(p, '/', end - p));
+				if (p == nullptr || p + 1 == end)
+					return false;
+				if (p[1] == '/') {
+					p = skip::LineEnd(p + 2, end);
+					if (p != end)
+						p++;
+				}
+				else if (p[1] == '*') {
+					auto q = skip::BlockEnd(p + 2, end);
+					if (q == end)
+						return true;
+					p = q + 2;
+				}
+				else
+					p++;
+			}
+			return false;
+		}
+
+		// 用最多 hardware_concurrency 个线程对 [0, n) 中的每个 i 调用一次 f(i)
+		template<typename F>
+		void parallelFor(std::size_t n, F f) {
+			std::size_t workers = std::min<std::size_t>(n, std::max(1u, std::thread::hardware_concurrency()));
+			std::atomic<std::size_t> next(0);
+			auto run = [&]() {
+				for (std::size_t i = next++; i < n; i = next++)
+					f(i);
+			};
+			std::vector<std::thread> threads;
+			for (std::size_t t = 1; t < workers; t++)
+				threads.emplace_back(run);
+			run();
+			for (auto& t : threads)
+				t.join();
+		}
+	}
+
+	std::pair<TokenStream, std::optional<CompilationError>>
+	ParallelTokenize(const SourceBuffer& src, unsigned chunks, LexerEngine engine) {
+		if (chunks <= 1 || src.size() < chunks) {
+			Tokenizer tkz(src, engine);
+			return tkz.AllTokenStream();
+		}
+
+		// 每一段是 [bounds[i], bounds[i + 1])，都以 \n 结尾
+		std::vector<std::size_t> bounds{ 0 };
+		for (unsigned i = 1; i < chunks; i++) {
+			auto at = std::max(src.size() / chunks * i, bounds.back());
+			auto nl = static_cast<const char*>(std::memchr(src.begin() + at, '\n', src.size() - at));
+			if (nl == nullptr)
+				break;
+			auto b = static_cast<std::size_t>(nl - src.begin()) + 1;
+			if (b > bounds.back() && b < src.size())
+				bounds.push_back(b);
+		}
+		bounds.push_back(src.size());
+		auto n = bounds.size() - 1;
+		auto at = [&](std::size_t offset) { return src.begin() + offset; };
+
+		// 预扫描：假设从代码状态进入，结尾是否在块注释里
+		// std::vector<bool> 不能在多个线程里同时写
+		std::vector<char> exits(n);
+		parallelFor(n, [&](std::size_t i) {
+			exits[i] = endsInComment(at(bounds[i]), at(bounds[i + 1]));
+		});
+
+		// 顺序推出每一段真正开始分析的位置
+		// 从块注释中进入的段很少，直接在这里找到注释的结尾并重新扫描，整段都是注释时 starts[i] 就是段尾
+		std::vector<std::size_t> starts(n);
+		bool in_comment = false;
+		for (std::size_t i = 0; i < n; i++) {
+			if (!in_comment) {
+				starts[i] = bounds[i];
+				in_comment = exits[i];
+				continue;
+			}
+			auto q = skip::BlockEnd(at(bounds[i]), at(bounds[i + 1]));
+			if (q == at(bounds[i + 1])) {
+				starts[i] = bounds[i + 1];
+				continue;
+			}
+			starts[i] = static_cast<std::size_t>(q + 2 - src.begin());
+			in_comment = endsInComment(q + 2, at(bounds[i + 1]));
+		}
+
+		std::vector<TokenStream> parts(n, TokenStream(src));
+		std::vector<std::optional<CompilationError>> errors(n);
+		parallelFor(n, [&](std::size_t i) {
+			if (starts[i] == bounds[i + 1])
+				return;
+			Tokenizer tkz(src, starts[i], bounds[i + 1], engine);
+			while (true) {
+				auto p = tkz.NextToken();
+				if (p.second.has_value()) {
+					if (p.second.value().GetCode() != ErrorCode::ErrEOF)
+						errors[i] = p.second;
+					break;
+				}
+				parts[i].push_back(p.first.value());
+			}
+		});
+
+		std::size_t total = 0;
+		for (auto& part : parts)
+			total += part.size();
+		TokenStream result(src);
+		result.reserve(total);
+		for (std::size_t i = 0; i < n; i++) {
+			// 块注释在段尾还没有结束，下一段会从注释结尾开始，这不是错误
+			auto unfinished = errors[i].has_value() && errors[i].value().GetCode() == ErrorCode::ErrUnfinishComment;
+			if (errors[i].has_value() && !(unfinished && i + 1 < n))
+				return std::make_pair(TokenStream(src), errors[i]);
+			result.append(parts[i]);
+		}
+		// 最后一段整个都在没有结束的块注释里
+		if (in_comment)
+			return std::make_pair(TokenStream(src), std::make_optional<CompilationError>(ErrorCode::ErrUnfinishComment));
+		return std::make_pair(std::move(result), std::optional<CompilationError>());
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "tokenizer/tokenizer.h"
+#include "tokenizer/token_stream.h"
+#include "tokenizer/source.h"
+#include "error/error.h"
+
+#include <utility>
+#include <optional>
+
+namespace miniplc0 {
+
+	// 并行词法分析
+	// 1.把缓冲区在 \n 之后切成 chunks 段（token 不会跨行）
+	// 2.并行预扫描每一段只看注释，得到从代码状态进入时，结尾是否还在块注释里，然后顺序推出每一段开头是否在块注释里
+	// 3.每一段用一个 Tokenizer 并行分析，按顺序拼接
+	// 结果（包括出错时返回的错误）和 Tokenizer(src, engine).AllTokenStream() 完全相同
+	std::pair<TokenStream, std::optional<CompilationError>>
+		ParallelTokenize(const SourceBuffer& src, unsigned chunks, LexerEngine engine = SWITCH_LEXER);
+}
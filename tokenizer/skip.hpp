@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstdint>
+
+// 跳过空白和注释
+// 生成的源码里大部分字节是空白和注释，这里按 32 字节（AVX2）或者 16 字节（SSE2）一次比较
+// 编译时没有打开对应指令集就退回到逐个字符比较，结果完全相同
+// 所有函数只读 [p, end)，找不到时返回 end
+//
+// 默认的编译选项没有 -mavx2，x86 上只保证有 SSE2
+// GCC/Clang 下另外编译一份 target("avx2") 的循环，运行时 CPU 支持才走这条路
+// MSVC 没有做运行时检测，要用 AVX2 需要自己加 /arch:AVX2
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MINIPLC0_SKIP_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MINIPLC0_SKIP_SSE2 1
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MINIPLC0_SKIP_AVX2_DISPATCH 1
+#endif
+#endif
+
+#if defined(_MSC_VER) && (defined(MINIPLC0_SKIP_AVX2) || defined(MINIPLC0_SKIP_SSE2))
+#include <intrin.h>
+#endif
+
+namespace miniplc0 {
+	namespace skip {
+
+		// 和 Tokenizer::isBlank 一致
+		inline bool isBlank(char ch) {
+			return ch == 0x20 || ch == 0x09 || ch == 0x0A || ch == 0x0D;
+		}
+
+		// 最低位的 1 的下标，调用者保证 mask 非 0
+		inline unsigned lowestBit(std::uint32_t mask) {
+#if defined(_MSC_VER)
+			unsigned long i;
+			_BitScanForward(&i, mask);
+			return static_cast<unsigned>(i);
+#else
+			return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+		}
+
+#if defined(MINIPLC0_SKIP_AVX2)
+		constexpr long stride = 32;
+		using Vec = __m256i;
+		inline Vec load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+		inline Vec splat(char c) { return _mm256_set1_epi8(c); }
+		inline Vec eq(Vec a, Vec b) { return _mm256_cmpeq_epi8(a, b); }
+		inline Vec either(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+		inline Vec both(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+		inline std::uint32_t bits(Vec a) { return static_cast<std::uint32_t>(_mm256_movemask_epi8(a)); }
+#elif defined(MINIPLC0_SKIP_SSE2)
+		constexpr long stride = 16;
+		using Vec = __m128i;
+		inline Vec load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+		inline Vec splat(char c) { return _mm_set1_epi8(c); }
+		inline Vec eq(Vec a, Vec b) { return _mm_cmpeq_epi8(a, b); }
+		inline Vec either(Vec a, Vec b) { return _mm_or_si128(a, b); }
+		inline Vec both(Vec a, Vec b) { return _mm_and_si128(a, b); }
+		inline std::uint32_t bits(Vec a) { return static_cast<std::uint32_t>(_mm_movemask_epi8(a)); }
+#endif
+
+#if defined(MINIPLC0_SKIP_AVX2) || defined(MINIPLC0_SKIP_SSE2)
+		// stride 个字节全为 1 时的掩码
+		constexpr std::uint32_t full = stride == 32 ? 0xFFFFFFFFu : 0xFFFFu;
+#endif
+
+#if defined(MINIPLC0_SKIP_AVX2_DISPATCH)
+		// 运行时选择的 AVX2 版本
+		// 每次 32 字节，找到了返回位置，剩下不到 32（块注释是 33）字节时返回停下的位置
+		// 调用者接着用 SSE2 和逐字符的循环从返回值继续，找到的位置会在第一次比较时再次命中
+		namespace avx2 {
+
+			inline const bool supported = [] {
+				__builtin_cpu_init();
+				return __builtin_cpu_supports("avx2") != 0;
+			}();
+
+			__attribute__((target("avx2"))) inline const char* Blanks(const char* p, const char* end) {
+				auto sp = _mm256_set1_epi8(' '), tab = _mm256_set1_epi8('\t');
+				auto lf = _mm256_set1_epi8('\n'), cr = _mm256_set1_epi8('\r');
+				for (; end - p >= 32; p += 32) {
+					auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+					auto b = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, tab)),
+					                         _mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr)));
+					auto m = static_cast<std::uint32_t>(_mm256_movemask_epi8(b));
+					if (m != 0xFFFFFFFFu)
+						return p + lowestBit(~m);
+				}
+				return p;
+			}
+
+			__attribute__((target("avx2"))) inline const char* LineEnd(const char* p, const char* end) {
+				auto lf = _mm256_set1_epi8('\n'), cr = _mm256_set1_epi8('\r');
+				for (; end - p >= 32; p += 32) {
+					auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+					auto m = static_cast<std::uint32_t>(_mm256_movemask_epi8(
+						_mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr))));
+					if (m != 0)
+						return p + lowestBit(m);
+				}
+				return p;
+			}
+
+			__attribute__((target("avx2"))) inline const char* BlockEnd(const char* p, const char* end) {
+				auto star = _mm256_set1_epi8('*'), slash = _mm256_set1_epi8('/');
+				for (; end - p > 32; p += 32) {
+					auto a = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), star);
+					auto b = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1)), slash);
+					auto m = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(a, b)));
+					if (m != 0)
+						return p + lowestBit(m);
+				}
+				return p;
+			}
+		}
+#endif
+
+		// 第一个不是空白的字符
+		inline const char* Blanks(const char* p, const char* end) {
+			// 大部分 token 之间只隔一个空格，先按字符看几个
+			for (int i = 0; i < 4; i++, p++)
+				if (p == end || !isBlank(*p))
+					return p;
+#if defined(MINIPLC0_SKIP_AVX2_DISPATCH)
+			if (avx2::supported)
+				p = avx2::Blanks(p, end);
+#endif
+#if defined(MINIPLC0_SKIP_AVX2) || defined(MINIPLC0_SKIP_SSE2)
+			auto sp = splat(' '), tab = splat('\t'), lf = splat('\n'), cr = splat('\r');
+			for (; end - p >= stride; p += stride) {
+				auto v = load(p);
+				auto m = bits(either(either(eq(v, sp), eq(v, tab)), either(eq(v, lf), eq(v, cr))));
+				if (m != full)
+					return p + lowestBit(~m & full);
+			}
+#endif
+			while (p != end && isBlank(*p))
+				++p;
+			return p;
+		}
+
+		// 行注释的结尾：第一个 \n 或者 \r
+		inline const char* LineEnd(const char* p, const char* end) {
+#if defined(MINIPLC0_SKIP_AVX2_DISPATCH)
+			if (avx2::supported)
+				p = avx2::LineEnd(p, end);
+#endif
+#if defined(MINIPLC0_SKIP_AVX2) || defined(MINIPLC0_SKIP_SSE2)
+			auto lf = splat('\n'), cr = splat('\r');
+			for (; end - p >= stride; p += stride) {
+				auto v = load(p);
+				auto m = bits(either(eq(v, lf), eq(v, cr)));
+				if (m != 0)
+					return p + lowestBit(m);
+			}
+#endif
+			while (p != end && *p != '\n' && *p != '\r')
+				++p;
+			return p;
+		}
+
+		// 块注释的结尾：第一个 */ 中 * 的位置
+		inline const char* BlockEnd(const char* p, const char* end) {
+#if defined(MINIPLC0_SKIP_AVX2_DISPATCH)
+			if (avx2::supported)
+				p = avx2::BlockEnd(p, end);
+#endif
+#if defined(MINIPLC0_SKIP_AVX2) || defined(MINIPLC0_SKIP_SSE2)
+			auto star = splat('*'), slash = splat('/');
+			// 同时比较 p 开始的 * 和 p + 1 开始的 /，所以要多留一个字节
+			for (; end - p > stride; p += stride) {
+				auto m = bits(both(eq(load(p), star), eq(load(p + 1), slash)));
+				if (m != 0)
+					return p + lowestBit(m);
+			}
+#endif
+			for (; end - p >= 2; ++p)
+				if (p[0] == '*' && p[1] == '/')
+					return p;
+			return end;
+		}
+	}
+}
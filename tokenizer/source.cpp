@@ -0,0 +1,135 @@
+#include "tokenizer/source.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MINIPLC0_HAS_MMAP 1
+#endif
+
+namespace miniplc0 {
+
+	std::optional<SourceBuffer> SourceBuffer::FromFile(const std::string& path) {
+#ifdef MINIPLC0_HAS_MMAP
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return {};
+		struct stat st;
+		if (::fstat(fd, &st) != 0) {
+			::close(fd);
+			return {};
+		}
+		auto size = static_cast<std::size_t>(st.st_size);
+		// 空文件不能映射；不以 \n 结尾的文件需要补一个 \n，映射的内存是只读的
+		// 这两种情况都退回到一次性读入
+		if (S_ISREG(st.st_mode) && size > 0) {
+			void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED) {
+				auto data = static_cast<const char*>(p);
+				if (data[size - 1] == '\n') {
+					::close(fd);
+#ifdef MADV_SEQUENTIAL
+					::madvise(p, size, MADV_SEQUENTIAL);
+#endif
+					SourceBuffer src;
+					src._data = data;
+					src._size = size;
+					src._mapped = true;
+					return src;
+				}
+				::munmap(p, size);
+			}
+		}
+		::close(fd);
+#endif
+		std::ifstream ifs(path, std::ios::in | std::ios::binary);
+		if (!ifs)
+			return {};
+		return FromStream(ifs);
+	}
+
+	SourceBuffer SourceBuffer::FromStream(std::istream& is) {
+		SourceBuffer src;
+		src._owned.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+		if (!src._owned.empty() && src._owned.back() != '\n')
+			src._owned.push_back('\n');
+		src._data = src._owned.data();
+		src._size = src._owned.size();
+		return src;
+	}
+
+	SourceBuffer::SourceBuffer(SourceBuffer&& src) noexcept : SourceBuffer() {
+		*this = std::move(src);
+	}
+
+	SourceBuffer& SourceBuffer::operator=(SourceBuffer&& src) noexcept {
+		if (this == &src)
+			return *this;
+		release();
+		_mapped = src._mapped;
+		_size = src._size;
+		_owned = std::move(src._owned);
+		// 短字符串优化会让 _owned 的地址随移动改变
+		_data = _mapped ? src._data : _owned.data();
+		_line_starts = std::move(src._line_starts);
+		_last_line = src._last_line;
+		src._data = nullptr;
+		src._size = 0;
+		src._mapped = false;
+		src._owned.clear();
+		src._line_starts.clear();
+		src._last_line = 0;
+		return *this;
+	}
+
+	SourceBuffer::~SourceBuffer() {
+		release();
+	}
+
+	void SourceBuffer::release() {
+#ifdef MINIPLC0_HAS_MMAP
+		if (_mapped && _data != nullptr)
+			::munmap(const_cast<char*>(_data), _size);
+#endif
+		_data = nullptr;
+		_size = 0;
+		_mapped = false;
+	}
+
+	void SourceBuffer::buildLineIndex() const {
+		_line_starts.clear();
+		_line_starts.push_back(0);
+		for (auto p = begin(); p != end();) {
+			auto nl = static_cast<const char*>(std::memchr(p, '\n', end() - p));
+			if (nl == nullptr)
+				break;
+			p = nl + 1;
+			_line_starts.push_back(p - begin());
+		}
+	}
+
+	std::pair<std::uint64_t, std::uint64_t> SourceBuffer::Position(std::size_t offset) const {
+		if (_line_starts.empty())
+			buildLineIndex();
+		// 词法分析时的查询基本是顺序的，先试一下上次的行和下一行
+		auto in_line = [&](std::size_t line) {
+			return line < _line_starts.size() && _line_starts[line] <= offset
+				&& (line + 1 == _line_starts.size() || offset < _line_starts[line + 1]);
+		};
+		std::size_t line = _last_line;
+		if (!in_line(line)) {
+			if (in_line(line + 1))
+				line++;
+			else
+				line = std::upper_bound(_line_starts.begin(), _line_starts.end(), offset) - _line_starts.begin() - 1;
+			_last_line = line;
+		}
+		return std::make_pair(static_cast<uint64_t>(line), static_cast<uint64_t>(offset - _line_starts[line]));
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <iostream>
+#include <optional>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace miniplc0 {
+
+	// 整个源文件的连续缓冲区
+	// 1.文件输入优先使用 mmap 映射，流输入一次性读入
+	// 2.缓冲区总是以 \n 结尾（和原来按行读入后补 \n 的行为一致）
+	// 3.行首偏移表只在第一次需要行号列号时建立
+	class SourceBuffer final {
+	private:
+		using uint64_t = std::uint64_t;
+	public:
+		// 映射一个文件，打开失败返回空
+		static std::optional<SourceBuffer> FromFile(const std::string& path);
+		// 一次读入整个流
+		static SourceBuffer FromStream(std::istream& is);
+
+		SourceBuffer() : _data(nullptr), _size(0), _mapped(false), _last_line(0) {}
+		SourceBuffer(SourceBuffer&& src) noexcept;
+		SourceBuffer& operator=(SourceBuffer&& src) noexcept;
+		SourceBuffer(const SourceBuffer&) = delete;
+		SourceBuffer& operator=(const SourceBuffer&) = delete;
+		~SourceBuffer();
+
+		const char* begin() const { return _data; }
+		const char* end() const { return _data + _size; }
+		std::size_t size() const { return _size; }
+		bool empty() const { return _size == 0; }
+
+		// 偏移 -> <行号，列号>，都从 0 开始
+		// 偏移可以等于 size()，此时返回 (行数, 0)，和 std::vector::end() 类似
+		std::pair<uint64_t, uint64_t> Position(std::size_t offset) const;
+	private:
+		void buildLineIndex() const;
+		void release();
+	private:
+		const char* _data;
+		std::size_t _size;
+		// _data 指向 mmap 的内存还是 _owned
+		bool _mapped;
+		std::string _owned;
+		// 每一行第一个字符的偏移，懒惰建立
+		mutable std::vector<std::size_t> _line_starts;
+		// 上一次查询落在的行
+		mutable std::size_t _last_line;
+	};
+}
@@ -0,0 +1,55 @@
+#include "tokenizer/tokenizer.h"
+#include "tokenizer/dfa_table.hpp"
+#include "tokenizer/skip.hpp"
+
+namespace miniplc0 {
+
+	// 和 nextToken 相同的语义，状态转移全部查 dfa::table
+	// 缓冲区总是以 \n 结尾，而除了注释以外的每个状态遇到 \n 都会接受，所以内层循环不需要检查文件尾
+	std::pair<std::optional<Token>, std::optional<CompilationError>> Tokenizer::nextTokenTable() {
+		auto end = _end;
+		while (true) {
+			// 跳过空白字符
+			_ptr = skip::Blanks(_ptr, end);
+			if (_ptr == end)
+				return std::make_pair(std::optional<Token>(), std::make_optional<CompilationError>(ErrorCode::ErrEOF));
+
+			const char* start = _ptr;
+			const char* p = _ptr;
+			std::uint8_t state = dfa::START;
+			do
+				state = dfa::table.next[state][static_cast<unsigned char>(*p++)];
+			while (state < dfa::states);
+
+			auto action = static_cast<dfa::Action>(state - dfa::states);
+			auto& info = dfa::action_info[action];
+			_ptr = p - info.backtrack;
+
+			if (action < dfa::A_SIMPLE_END)
+				return std::make_pair(std::make_optional<Token>(makeToken(info.kind, start)), std::optional<CompilationError>());
+			switch (action) {
+			case dfa::A_DEC:
+				return makeInteger(info.kind, start, start, 10);
+			case dfa::A_HEX:
+				return makeInteger(info.kind, start, start + 2, 16);
+			case dfa::A_IDENT:
+				return makeIdentifier(start);
+			case dfa::A_LINE_COMMENT:
+				skipLineComment();
+				break;
+			case dfa::A_BLOCK_COMMENT: {
+				auto err = skipBlockComment();
+				if (err.has_value())
+					return std::make_pair(std::optional<Token>(), err);
+				break;
+			}
+			case dfa::A_INVALID:
+				// 和 nextToken 一样报告在 (0, 0)
+				return std::make_pair(std::optional<Token>(), std::make_optional<CompilationError>(ErrorCode::ErrInvalidInput));
+			default:
+				DieAndPrint("unhandled dfa action.");
+				break;
+			}
+		}
+	}
+}
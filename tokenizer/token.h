@@ -2,8 +2,10 @@
 
 #include "error/error.h"
 
-#include <any>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <cstdint>
 
 namespace miniplc0 {
@@ -51,64 +53,45 @@ namespace miniplc0 {
 		EQUAL
 	};
 
+	// Token 是平凡可复制的：类型、源码中的文本视图、预先解析好的整数值和起始偏移
+	// 文本视图指向源码缓冲区，所以缓冲区必须比 Token 活得久
+	// 行号列号不在这里存，需要时用偏移去 SourceBuffer::Position 换算
 	class Token final {
 	private:
-		using uint64_t = std::uint64_t;
+		using uint32_t = std::uint32_t;
 		using int32_t = std::int32_t;
 	public:
-
-		friend void swap(Token& lhs, Token& rhs);
-
-	public:
-
-		Token(TokenType type, std::any value, uint64_t start_line, uint64_t start_column, uint64_t end_line, uint64_t end_column)
-			: _type(type), _value(std::move(value)), _start_pos(start_line, start_column), _end_pos(end_line, end_column) {}
-		Token(TokenType type, std::any value, std::pair<uint64_t, uint64_t> start, std::pair<uint64_t, uint64_t> end)
-			: Token(type, value, start.first, start.second, end.first, end.second) {}
-        Token(TokenType type, std::any value ) : _type(type),_value(std::move(value)) {}
-		Token(const Token& t) { _type = t._type;  _value = t._value; _start_pos = t._start_pos; _end_pos = t._end_pos; }
-		Token(Token&& t) : Token(TokenType::NULL_TOKEN, nullptr, 0, 0, 0, 0) { swap(*this, t); }
-		Token& operator=(Token t) { swap(*this, t); return *this; }
-		bool operator==(const Token& rhs) const { 
-			return _type == rhs._type 
-				&& GetValueString() == rhs.GetValueString() 
-				&& _start_pos == rhs._start_pos 
-				&& _end_pos == rhs._end_pos; 
+		Token(TokenType type, std::string_view text, int32_t value, uint32_t offset)
+			: _type(type), _value(value), _offset(offset), _text(text) {}
+		Token(TokenType type, std::string_view text) : Token(type, text, 0, 0) {}
+		bool operator==(const Token& rhs) const {
+			return _type == rhs._type
+				&& _value == rhs._value
+				&& _text == rhs._text
+				&& _offset == rhs._offset;
 		}
 
 		TokenType GetType() const { return _type; };
-		std::any GetValue() const { return _value; };
-		std::pair<uint64_t, uint64_t> GetStartPos() const { return _start_pos; }
-		std::pair<uint64_t, uint64_t> GetEndPos() const { return _end_pos; }
+		// 整数字面量的值，其他 token 为 0
+		int32_t GetIntValue() const { return _value; }
+		// token 在源码中的原文
+		std::string_view GetText() const { return _text; }
+		// 第一个字符在缓冲区中的偏移
+		uint32_t GetOffset() const { return _offset; }
+		// 最后一个字符之后的偏移
+		uint32_t GetEndOffset() const { return _offset + static_cast<uint32_t>(_text.size()); }
+		// 整数字面量统一输出十进制，其他 token 就是原文
 		std::string GetValueString() const {
-			try {
-				return std::any_cast<std::string>(_value);
-			}
-			catch (const std::bad_any_cast&) {}
-			try {
-				return std::string(1, std::any_cast<char>(_value));
-			}
-			catch (const std::bad_any_cast&) {}
-			try {
-				return std::to_string(std::any_cast<int32_t>(_value));
-			}
-			catch (const std::bad_any_cast&) {
-				DieAndPrint("No suitable cast for token value.");
-			}
-			return "Invalid";
+			if (_type == TokenType::UNSIGNED_INTEGER || _type == TokenType::UNSIGNED_HEX_INTEGER)
+				return std::to_string(_value);
+			return std::string(_text);
 		}
 	private:
 		TokenType _type;
-		std::any _value;
-		std::pair<uint64_t, uint64_t> _start_pos;
-		std::pair<uint64_t, uint64_t> _end_pos;
+		int32_t _value;
+		uint32_t _offset;
+		std::string_view _text;
 	};
 
-	inline void swap(Token& lhs, Token& rhs) {
-		using std::swap;
-		swap(lhs._type, rhs._type);
-		swap(lhs._value, rhs._value);
-		swap(lhs._start_pos, rhs._start_pos);
-		swap(lhs._end_pos, rhs._end_pos);
-	}
+	static_assert(std::is_trivially_copyable<Token>::value, "Token should be trivially copyable.");
 }
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "tokenizer/token_cache.h"
+#include "tokenizer/token.h"
+#include "tokenizer/incremental.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MINIPLC0_HAS_MMAP 1
+#endif
+
+namespace miniplc0 {
+
+	namespace {
+
+		// token 类型或者列的布局变化时加一
+		const std::uint32_t cache_version = 2;
+		const char cache_magic[4] = { 'C', '0', 'T', 'K' };
+
+		struct CacheHeader {
+			char magic[4];
+			std::uint32_t version;
+			std::uint64_t source_size;
+			std::uint64_t source_hash;
+			std::uint64_t count;
+		};
+
+		// 每个 token：偏移(4) + 长度(4) + 值(4) + 类型(1)，类型放最后，前面的列都是 4 字节对齐的
+		const std::uint64_t bytes_per_token = 13;
+
+		std::uint64_t rotl(std::uint64_t x, int r) {
+			return (x << r) | (x >> (64 - r));
+		}
+
+		// 只读的整个文件，优先 mmap
+		class FileView final {
+		public:
+			explicit FileView(const std::string& path) : _data(nullptr), _size(0), _mapped(false) {
+#ifdef MINIPLC0_HAS_MMAP
+				int fd = ::open(path.c_str(), O_RDONLY);
+				if (fd < 0)
+					return;
+				struct stat st;
+				if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+					void* p = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+					if (p != MAP_FAILED) {
+						_data = static_cast<const char*>(p);
+						_size = static_cast<std::size_t>(st.st_size);
+						_mapped = true;
+					}
+				}
+				::close(fd);
+				if (_mapped)
+					return;
+#endif
+				std::ifstream ifs(path, std::ios::in | std::ios::binary);
+				if (!ifs)
+					return;
+				_owned.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+				_data = _owned.data();
+				_size = _owned.size();
+			}
+			FileView(const FileView&) = delete;
+			FileView& operator=(const FileView&) = delete;
+			~FileView() {
+#ifdef MINIPLC0_HAS_MMAP
+				if (_mapped)
+					::munmap(const_cast<char*>(_data), _size);
+#endif
+			}
+
+			const char* data() const { return _data; }
+			std::size_t size() const { return _size; }
+		private:
+			const char* _data;
+			std::size_t _size;
+			bool _mapped;
+			std::string _owned;
+		};
+
+		// 文件头之后是 count 个 token 的各列，最后是写缓存时的源码原文，增量词法分析时用它找出改动的位置
+		// 返回空表示不是这个版本的缓存文件
+		std::optional<CacheHeader> readHeader(const FileView& file) {
+			if (file.size() < sizeof(CacheHeader))
+				return {};
+			CacheHeader header;
+			std::memcpy(&header, file.data(), sizeof(header));
+			if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 || header.version != cache_version)
+				return {};
+			auto body = file.size() - sizeof(header);
+			if (header.source_size > body || header.count > (body - header.source_size) / bytes_per_token
+				|| body != header.source_size + header.count * bytes_per_token)
+				return {};
+			return header;
+		}
+
+		template<typename T>
+		void readColumn(std::vector<T>& column, const char*& p, std::size_t count) {
+			column.resize(count);
+			if (count != 0)
+				std::memcpy(column.data(), p, count * sizeof(T));
+			p += count * sizeof(T);
+		}
+
+		template<typename T>
+		bool writeColumn(std::FILE* f, const std::vector<T>& column) {
+			return column.empty() || std::fwrite(column.data(), sizeof(T), column.size(), f) == column.size();
+		}
+	}
+
+	// 单路的 xxHash64 轮函数，每次 8 个字节，最后做一次雪崩
+	std::uint64_t SourceHash(const SourceBuffer& src) {
+		const std::uint64_t p1 = 0x9E3779B185EBCA87ULL, p2 = 0xC2B2AE3D27D4EB4FULL, p3 = 0x165667B19E3779F9ULL;
+		std::uint64_t h = p3 ^ (src.size() * p1);
+		const char* p = src.begin();
+		const char* end = src.end();
+		for (; end - p >= 8; p += 8) {
+			std::uint64_t w;
+			std::memcpy(&w, p, 8);
+			h = rotl(h ^ rotl(w * p2, 31) * p1, 27) * p1 + p3;
+		}
+		for (; p != end; p++)
+			h = rotl(h ^ static_cast<unsigned char>(*p) * p3, 11) * p1;
+		h ^= h >> 33;
+		h *= p2;
+		h ^= h >> 29;
+		h *= p3;
+		h ^= h >> 32;
+		return h;
+	}
+
+	bool SaveTokenCache(const std::string& path, const TokenStream& tokens) {
+		if (!tokens.contiguous()) {
+			auto copy = tokens;
+			copy.compact();
+			return SaveTokenCache(path, copy);
+		}
+		CacheHeader header;
+		std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+		header.version = cache_version;
+		header.source_size = tokens.Source().size();
+		header.source_hash = SourceHash(tokens.Source());
+		header.count = tokens.size();
+
+		auto tmp = path + ".tmp";
+		std::FILE* f = std::fopen(tmp.c_str(), "wb");
+		if (f == nullptr)
+			return false;
+		bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1
+			&& writeColumn(f, tokens._offsets)
+			&& writeColumn(f, tokens._lengths)
+			&& writeColumn(f, tokens._values)
+			&& writeColumn(f, tokens._kinds)
+			&& (header.source_size == 0 || std::fwrite(tokens.Source().begin(), 1, tokens.Source().size(), f) == tokens.Source().size());
+		ok = std::fclose(f) == 0 && ok;
+		if (ok && std::rename(tmp.c_str(), path.c_str()) != 0) {
+			// Windows 上目标文件已经存在时不能改名
+			std::remove(path.c_str());
+			ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+		}
+		if (!ok)
+			std::remove(tmp.c_str());
+		return ok;
+	}
+
+	std::optional<TokenStream> LoadTokenCache(const std::string& path, const SourceBuffer& src) {
+		FileView file(path);
+		auto h = readHeader(file);
+		if (!h.has_value())
+			return {};
+		auto header = h.value();
+		if (header.source_size != src.size() || header.source_hash != SourceHash(src))
+			return {};
+
+		auto count = static_cast<std::size_t>(header.count);
+		TokenStream tokens(src);
+		const char* p = file.data() + sizeof(header);
+		readColumn(tokens._offsets, p, count);
+		readColumn(tokens._lengths, p, count);
+		readColumn(tokens._values, p, count);
+		readColumn(tokens._kinds, p, count);
+		tokens._gap = count;
+		// 哈希对上了也不完全信任文件内容，越界的视图会读到缓冲区外面
+		for (std::size_t i = 0; i < count; i++)
+			if (tokens._kinds[i] > TokenType::EQUAL || tokens._offsets[i] > src.size()
+				|| tokens._lengths[i] > src.size() - tokens._offsets[i])
+				return {};
+		return tokens;
+	}
+
+	std::optional<TokenStream> RelexTokenCache(const std::string& path, const SourceBuffer& src, LexerEngine engine) {
+		FileView file(path);
+		auto h = readHeader(file);
+		if (!h.has_value())
+			return {};
+		auto header = h.value();
+		auto count = static_cast<std::size_t>(header.count);
+		std::string_view before(file.data() + sizeof(header) + count * bytes_per_token, header.source_size);
+		if (SourceHash(src) == header.source_hash && before == std::string_view(src.begin(), src.size()))
+			return LoadTokenCache(path, src);
+
+		// 旧的 token 只用到偏移和长度，不会读原文，先挂在 src 上
+		std::vector<std::uint32_t> offsets, lengths;
+		std::vector<std::int32_t> values;
+		std::vector<std::uint8_t> kinds;
+		const char* p = file.data() + sizeof(header);
+		readColumn(offsets, p, count);
+		readColumn(lengths, p, count);
+		readColumn(values, p, count);
+		readColumn(kinds, p, count);
+		TokenStream tokens(src);
+		tokens.reserve(count);
+		for (std::size_t i = 0; i < count; i++) {
+			if (kinds[i] > TokenType::EQUAL || offsets[i] > before.size() || lengths[i] > before.size() - offsets[i]
+				|| (i > 0 && offsets[i] < offsets[i - 1] + lengths[i - 1]))
+				return {};
+			tokens.push_back(Token(static_cast<TokenType>(kinds[i]), before.substr(offsets[i], lengths[i]), values[i], offsets[i]));
+		}
+		auto r = Retokenize(std::move(tokens), src, FindEdit(before, src), engine);
+		// 有词法错误时交给完整的词法分析报告
+		if (r.second.has_value())
+			return {};
+		return std::move(r.first);
+	}
+}
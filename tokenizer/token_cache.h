@@ -0,0 +1,32 @@
+#pragma once
+
+#include "tokenizer/token_stream.h"
+#include "tokenizer/tokenizer.h"
+#include "tokenizer/source.h"
+
+#include <optional>
+#include <string>
+#include <cstdint>
+
+namespace miniplc0 {
+
+	// token 缓存文件
+	// 文件头记录格式版本、源码长度和内容哈希，后面按列存放 偏移、长度、值、类型，最后是源码原文
+	// 使用本机字节序，只在同一台机器上复用
+	// 源码内容变了哈希就对不上，缓存自动失效
+
+	// 整个源码的 64 位内容哈希
+	std::uint64_t SourceHash(const SourceBuffer& src);
+
+	// 先写临时文件再改名，不会留下写了一半的缓存
+	// 失败返回 false，缓存只是加速，失败了不影响编译
+	bool SaveTokenCache(const std::string& path, const TokenStream& tokens);
+
+	// 映射缓存文件并检查是否和 src 匹配
+	// 文件不存在、格式不对、版本不同或者和 src 不匹配都返回空，这时应该重新词法分析
+	std::optional<TokenStream> LoadTokenCache(const std::string& path, const SourceBuffer& src);
+
+	// 缓存是为 src 修改之前的版本写的时，用缓存里的原文找出改动的范围，只重新分析改动附近的 token
+	// 结果和完整的词法分析相同；缓存不可用或者有词法错误时返回空，这时应该重新词法分析
+	std::optional<TokenStream> RelexTokenCache(const std::string& path, const SourceBuffer& src, LexerEngine engine);
+}
@@ -0,0 +1,121 @@
+#include "tokenizer/token_stream.h"
+
+#include <algorithm>
+
+namespace miniplc0 {
+
+	void TokenStream::push_back(const Token& t) {
+		if (!contiguous())
+			compact();
+		_kinds.push_back(static_cast<uint8_t>(t.GetType()));
+		_offsets.push_back(t.GetOffset());
+		_lengths.push_back(static_cast<uint32_t>(t.GetText().size()));
+		_values.push_back(t.GetIntValue());
+		_gap++;
+	}
+
+	void TokenStream::reserve(std::size_t n) {
+		_kinds.reserve(n + _gap_len);
+		_offsets.reserve(n + _gap_len);
+		_lengths.reserve(n + _gap_len);
+		_values.reserve(n + _gap_len);
+	}
+
+	void TokenStream::append(const TokenStream& ts) {
+		if (ts._src != _src)
+			DieAndPrint("appending a token stream of another source.");
+		if (!contiguous())
+			compact();
+		if (!ts.contiguous()) {
+			reserve(size() + ts.size());
+			for (std::size_t i = 0; i < ts.size(); i++)
+				push_back(ts[i]);
+			return;
+		}
+		_kinds.insert(_kinds.end(), ts._kinds.begin(), ts._kinds.end());
+		_offsets.insert(_offsets.end(), ts._offsets.begin(), ts._offsets.end());
+		_lengths.insert(_lengths.end(), ts._lengths.begin(), ts._lengths.end());
+		_values.insert(_values.end(), ts._values.begin(), ts._values.end());
+		_gap = _kinds.size();
+	}
+
+	namespace {
+		// 把 [first, last) 移到 d 开始的位置，两段可以重叠
+		template<typename T>
+		void moveRange(std::vector<T>& v, std::size_t first, std::size_t last, std::size_t d) {
+			if (d < first)
+				std::copy(v.begin() + first, v.begin() + last, v.begin() + d);
+			else
+				std::copy_backward(v.begin() + first, v.begin() + last, v.begin() + d + (last - first));
+		}
+
+		// 在 at 处插入 n 个空位
+		template<typename T>
+		void openRange(std::vector<T>& v, std::size_t at, std::size_t n) {
+			v.insert(v.begin() + at, n, T());
+		}
+	}
+
+	void TokenStream::moveGap(std::size_t i) {
+		if (i < _gap) {
+			// [i, _gap) 移到间隙之后，偏移换成相对 _tail_shift 的
+			auto n = _gap - i;
+			for (std::size_t k = i; k < _gap; k++)
+				_offsets[k] -= _tail_shift;
+			moveRange(_kinds, i, _gap, i + _gap_len);
+			moveRange(_offsets, i, _gap, i + _gap_len);
+			moveRange(_lengths, i, _gap, i + _gap_len);
+			moveRange(_values, i, _gap, i + _gap_len);
+			_gap -= n;
+		} else if (i > _gap) {
+			auto from = _gap + _gap_len, to = i + _gap_len;
+			moveRange(_kinds, from, to, _gap);
+			moveRange(_offsets, from, to, _gap);
+			moveRange(_lengths, from, to, _gap);
+			moveRange(_values, from, to, _gap);
+			for (std::size_t k = _gap; k < i; k++)
+				_offsets[k] += _tail_shift;
+			_gap = i;
+		}
+	}
+
+	void TokenStream::compact() {
+		moveGap(size());
+		_kinds.resize(_gap);
+		_offsets.resize(_gap);
+		_lengths.resize(_gap);
+		_values.resize(_gap);
+		_gap_len = 0;
+		_tail_shift = 0;
+	}
+
+	void TokenStream::splice(std::size_t first, std::size_t last, const TokenStream& ts, std::int64_t shift) {
+		if (first > last || last > size())
+			DieAndPrint("splicing an invalid range of a token stream.");
+		// [first, last) 放到间隙前面再并入间隙，之后的 token 都在间隙后面，平移只需要改 _tail_shift
+		moveGap(last);
+		_gap = first;
+		_gap_len += last - first;
+		_tail_shift = static_cast<uint32_t>(_tail_shift + shift);
+		if (_gap_len < ts.size()) {
+			// 间隙按总长的一半扩大，连续编辑时均摊下来不用每次都挪动后面的 token
+			auto grow = std::max(ts.size() - _gap_len, size() / 2 + 16);
+			openRange(_kinds, _gap, grow);
+			openRange(_offsets, _gap, grow);
+			openRange(_lengths, _gap, grow);
+			openRange(_values, _gap, grow);
+			_gap_len += grow;
+		}
+		for (std::size_t i = 0; i < ts.size(); i++, _gap++, _gap_len--) {
+			_kinds[_gap] = static_cast<uint8_t>(ts.Kind(i));
+			_offsets[_gap] = ts.Offset(i);
+			_lengths[_gap] = ts.Length(i);
+			_values[_gap] = ts.Value(i);
+		}
+		_src = ts._src;
+	}
+
+	Token TokenStream::operator[](std::size_t i) const {
+		return Token(Kind(i), Text(i), Value(i), Offset(i));
+	}
+}
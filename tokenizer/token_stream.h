@@ -0,0 +1,78 @@
+#pragma once
+
+#include "tokenizer/token.h"
+#include "tokenizer/source.h"
+
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <optional>
+
+namespace miniplc0 {
+
+	// 整个 token 序列，按列存储
+	// 每个 token 只占 类型(1) + 偏移(4) + 长度(4) + 值(4) 个字节，原文从源码缓冲区取
+	// 缓冲区必须比 TokenStream 活得久
+	//
+	// 为了增量词法分析，每一列都是一个间隙缓冲区：下标 [_gap, _gap + _gap_len) 的位置是空的
+	// 间隙之后的 token 存的是 偏移 - _tail_shift（按 2^32 取模），替换时后面的 token 整体平移只要改 _tail_shift
+	// 连续几次编辑的位置相近时，每次只需要移动两次编辑之间的 token
+	// 不做编辑时间隙总是在最后并且长度为 0，访问时的判断总是成立
+	class TokenStream final {
+	private:
+		using uint8_t = std::uint8_t;
+		using uint32_t = std::uint32_t;
+		using int32_t = std::int32_t;
+	public:
+		explicit TokenStream(const SourceBuffer& src) : _src(&src), _gap(0), _gap_len(0), _tail_shift(0) {}
+
+		// t 必须来自 Source()
+		void push_back(const Token& t);
+		void reserve(std::size_t n);
+		// 把 ts 的 token 接在后面，ts 必须使用同一个缓冲区
+		void append(const TokenStream& ts);
+		// 用 ts 替换 [first, last) 的 token，之后的 token 偏移都加上 shift，然后改用 ts 的缓冲区
+		// 除了移动间隙，代价只和替换的 token 数有关
+		void splice(std::size_t first, std::size_t last, const TokenStream& ts, std::int64_t shift);
+		// 把间隙移到最后并释放掉，之后每一列都是连续的
+		void compact();
+		std::size_t size() const { return _kinds.size() - _gap_len; }
+		bool empty() const { return size() == 0; }
+
+		TokenType Kind(std::size_t i) const { return static_cast<TokenType>(_kinds[at(i)]); }
+		// 第一个字符在缓冲区中的偏移
+		uint32_t Offset(std::size_t i) const { return i < _gap ? _offsets[i] : _offsets[i + _gap_len] + _tail_shift; }
+		uint32_t Length(std::size_t i) const { return _lengths[at(i)]; }
+		// 整数字面量的值，其他 token 为 0
+		int32_t Value(std::size_t i) const { return _values[at(i)]; }
+		std::string_view Text(std::size_t i) const { return std::string_view(_src->begin() + Offset(i), Length(i)); }
+		// token 最后一个字符之后的偏移
+		uint32_t EndOffset(std::size_t i) const { return Offset(i) + Length(i); }
+		// 还原成一个 Token，只是几个视图，不复制原文
+		Token operator[](std::size_t i) const;
+
+		const SourceBuffer& Source() const { return *_src; }
+	private:
+		// 第 i 个 token 在每一列中的位置
+		std::size_t at(std::size_t i) const { return i < _gap ? i : i + _gap_len; }
+		// 把间隙移到第 i 个 token 之前
+		void moveGap(std::size_t i);
+		// 每一列都是连续的，并且间隙之后没有 token
+		bool contiguous() const { return _gap_len == 0 && _gap == _kinds.size(); }
+	private:
+		// 缓存文件直接读写每一列，见 token_cache.h
+		friend bool SaveTokenCache(const std::string& path, const TokenStream& tokens);
+		friend std::optional<TokenStream> LoadTokenCache(const std::string& path, const SourceBuffer& src);
+		const SourceBuffer* _src;
+		std::vector<uint8_t> _kinds;
+		std::vector<uint32_t> _offsets;
+		std::vector<uint32_t> _lengths;
+		std::vector<int32_t> _values;
+		// 间隙之前的 token 数
+		std::size_t _gap;
+		std::size_t _gap_len;
+		uint32_t _tail_shift;
+	};
+}
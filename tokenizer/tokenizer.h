@@ -1,6 +1,8 @@
 #pragma once
 
 #include "tokenizer/token.h"
+#include "tokenizer/source.h"
+#include "tokenizer/token_stream.h"
 #include "tokenizer/utils.hpp"
 #include "error/error.h"
 
@@ -14,6 +16,15 @@
 
 namespace miniplc0 {
 
+	// 词法分析的实现
+	// 两者输出的 token 序列（包括出错时的错误）完全相同
+	enum LexerEngine {
+		// 手写的 switch 状态机
+		SWITCH_LEXER,
+		// 编译期生成的状态转移表，见 tokenizer/dfa_table.hpp
+		TABLE_LEXER
+	};
+
 	class Tokenizer final {
 	private:
 		using uint64_t = std::uint64_t;
@@ -43,8 +54,16 @@ namespace miniplc0 {
             EQUAL_STATE
 		};
 	public:
-		Tokenizer(std::istream& ifs)
-			: _rdr(ifs), _initialized(false), _ptr(0, 0),_lines_buffer() {}
+		Tokenizer(std::istream& ifs, LexerEngine engine = SWITCH_LEXER)
+			: _rdr(&ifs), _initialized(false), _owned(), _src(nullptr), _ptr(nullptr), _end(nullptr), _engine(engine) {}
+		// 直接在一个已经准备好的缓冲区（比如 mmap 的文件）上分析，缓冲区必须比 Tokenizer 活得久
+		Tokenizer(const SourceBuffer& src, LexerEngine engine = SWITCH_LEXER)
+			: _rdr(nullptr), _initialized(false), _owned(), _src(&src), _ptr(nullptr), _end(nullptr), _engine(engine) {}
+		// 只分析缓冲区中 [begin, end) 这一段，begin 不能在注释中间，end 之前的字符必须是 \n
+		// token 和错误的偏移仍然相对整个缓冲区
+		Tokenizer(const SourceBuffer& src, std::size_t begin, std::size_t end, LexerEngine engine = SWITCH_LEXER)
+			: _rdr(nullptr), _initialized(false), _owned(), _src(&src),
+			_ptr(src.begin() + begin), _end(src.begin() + end), _engine(engine) {}
 		Tokenizer(Tokenizer&& tkz) = delete;
 		Tokenizer(const Tokenizer&) = delete;
 		Tokenizer& operator=(const Tokenizer&) = delete;
@@ -53,6 +72,10 @@ namespace miniplc0 {
 		std::pair<std::optional<Token>, std::optional<CompilationError>> NextToken();
 		// 一次返回所有 token
 		std::pair<std::vector<Token>, std::optional<CompilationError>> AllTokens();
+		// 同上，但是按列存储，结果引用这个 Tokenizer 使用的缓冲区
+		std::pair<TokenStream, std::optional<CompilationError>> AllTokenStream();
+		// 正在分析的缓冲区，流输入时在第一次取 token 之后才有
+		const SourceBuffer* Source() const { return _src; }
 	private:
 		// 检查 Token 的合法性
 		std::optional<CompilationError> checkToken(const Token&);
@@ -61,42 +84,58 @@ namespace miniplc0 {
 		//
 		// 返回下一个 token，是 NextToken 实际实现部分
 		std::pair<std::optional<Token>, std::optional<CompilationError>> nextToken();
+		// 查表实现的 nextToken，定义于 tokenizer/table_lexer.cpp
+		std::pair<std::optional<Token>, std::optional<CompilationError>> nextTokenTable();
+		// 用 [start, 当前指针) 这一段源码构造 token
+		Token makeToken(TokenType type, const char* start, std::int32_t value = 0);
+		// p 在缓冲区中的偏移
+		std::uint32_t offsetOf(const char* p) const { return static_cast<std::uint32_t>(p - _src->begin()); }
+
+		// 下面几个函数由两种实现共用，保证它们的行为一致
+		// 把 [digits, 当前指针) 按 base 进制解析成整数字面量，token 从 start 开始
+		std::pair<std::optional<Token>, std::optional<CompilationError>>
+			makeInteger(TokenType type, const char* start, const char* digits, int base);
+		// [start, 当前指针) 是一个标识符或者关键字
+		std::pair<std::optional<Token>, std::optional<CompilationError>> makeIdentifier(const char* start);
+		// 已经读过 //，跳到行尾（包括 \n 或者 \r）
+		void skipLineComment();
+		// 已经读过 /*，跳到 */ 之后，没有结束返回 ErrUnfinishComment
+		std::optional<CompilationError> skipBlockComment();
 
-		// 从这里开始其实是一个基于行号的缓冲区的实现
-		// 为了简单起见，我们没有单独拿出一个类实现
-		// 核心思想和 C 的文件输入输出类似，就是一个 buffer 加一个指针，有三个细节
-		// 1.缓冲区包括 \n
+		// 从这里开始是缓冲区的实现
+		// 核心思想和 C 的文件输入输出类似，就是一个连续的 buffer 加一个指针，有三个细节
+		// 1.缓冲区包括 \n，并且总是以 \n 结尾
 		// 2.指针始终指向下一个要读取的 char
-		// 3.行号和列号从 0 开始
+		// 3.token 只记录偏移，行号和列号从 0 开始，只在输出时通过 SourceBuffer 的行首偏移表换算
 
-		// 一次读入全部内容，并且替换所有换行为 \n
-		// 这样其实是不合理的，这里只是简单起见这么实现
+		// 如果是流输入，一次读入全部内容
 		void readAll();
 		// 一个简单的总结
-		// 偏移   | 0 | 1 | 2 | 3 | 4 | 4 | 5 | 6 | 7 | 8 | 9  |
-		//        | = | = | = | = | = | = | = | = | = | = | =  |
-		// 缓冲区 | h | a | 1 | 9 | 2 | 6 | 0 | 8 | 1 | 7 | \n |（第0行）
-		//        | 1 | 1 | 4 | 5 | 1 | 4 |                     （第1行）
-		// 这里假设指针指向第一行的 \n，那么有
-		// nextPos() = (1, 0)
-		// currentPos() = (0, 9)
-		// previousPos() = (0, 8)
-		// nextChar() = '\n' 并且指针移动到 (1, 0)
-		// unreadLast() 指针移动到 (0, 8)
-		std::pair<uint64_t, uint64_t> nextPos();
-		std::pair<uint64_t, uint64_t> currentPos();
-		std::pair<uint64_t, uint64_t> previousPos();
+		// 偏移   | 0 | 1 | 2 | 3 | 4 | 5 | 6 | 7 | 8 | 9 | 10 | 11 | 12 | 13 | 14 | 15 | 16 | 17 |
+		//        | = | = | = | = | = | = | = | = | = | = | =  | =  | =  | =  | =  | =  | =  | =  |
+		// 缓冲区 | h | a | 1 | 9 | 2 | 6 | 0 | 8 | 1 | 7 | \n | 1  | 1  | 4  | 5  | 1  | 4  | \n |
+		// 这里假设指针指向偏移 10 的 \n（第0行第10列），那么有
+		// nextChar() = '\n' 并且指针移动到偏移 11，即 (1, 0)
+		// unreadLast() 指针移动到偏移 9
+		// token 的位置就是 makeToken 时的偏移
 		std::optional<char> nextChar();
 		bool isEOF();
 		bool isBlank(char);
 		void unreadLast();
 	private:
-		std::istream& _rdr;
+		// 流输入时非空
+		std::istream* _rdr;
 		// 如果没有初始化，那么就 readAll
 		bool _initialized;
+		// 流输入时读入的缓冲区
+		SourceBuffer _owned;
+		// 实际使用的缓冲区
+		const SourceBuffer* _src;
 		// 指向下一个要读取的字符
-		std::pair<uint64_t, uint64_t> _ptr;
-		// 以行为基础的缓冲区
-		std::vector<std::string> _lines_buffer;
+		const char* _ptr;
+		// 分析到这里为止，一般就是缓冲区的结尾
+		const char* _end;
+		// 使用哪一种实现
+		LexerEngine _engine;
 	};
 }
\ No newline at end of file